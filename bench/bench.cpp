@@ -0,0 +1,277 @@
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "frustum.hpp"
+#include "packet.hpp"
+#include "render.hpp"
+#include "wavefront.hpp"
+
+// micro benchmarks for the runtime hot paths, run with no arguments...
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename F> auto time_ns(F&& f) -> double {
+  const auto start = clock_type::now();
+  f();
+  return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+// keeps the optimiser from throwing the work away
+template <typename T> void do_not_optimise(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+void bench_sphere_hit() {
+  constexpr std::size_t grid = 256;
+  constexpr std::size_t repeats = 64;
+
+  const rt::sphere_d s{{0.0, 0.0, -1.0}, 0.5};
+  const auto cam = rt::camera_for<grid, grid>();
+  std::vector<rt::ray_d> rays;
+  rays.reserve(grid * grid);
+  for (std::size_t j = 0; j < grid; ++j) {
+    for (std::size_t i = 0; i < grid; ++i) {
+      rays.push_back(cam.get_ray(static_cast<double>(i) / static_cast<double>(grid - 1),
+                                 static_cast<double>(j) / static_cast<double>(grid - 1)));
+    }
+  }
+
+  std::size_t hits = 0;
+  const double ns = time_ns([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      for (const auto& ray : rays) {
+        const auto h = s.hit(ray, 0.001, std::numeric_limits<double>::infinity());
+        if (h) {
+          hits += 1;
+        }
+        do_not_optimise(h);
+      }
+    }
+  });
+
+  const auto tests = static_cast<double>(repeats * rays.size());
+  std::cout << "sphere::hit      " << ns / tests << " ns/test (" << hits << " hits)\n";
+}
+
+// same rays as above, 16 at a time
+void bench_sphere_hit_packet() {
+  constexpr std::size_t grid = 256;
+  constexpr std::size_t repeats = 64;
+  constexpr std::size_t lanes = 16;
+
+  const rt::sphere_d s{{0.0, 0.0, -1.0}, 0.5};
+  const rt::camera_rays<grid, grid> camera_table{rt::camera_for<grid, grid>()};
+  rt::lane_mask<lanes> active{};
+  active.fill(true);
+  std::vector<rt::ray_packet<double, lanes>> packets;
+  for (std::size_t k = 0; k < grid * grid; k += lanes) {
+    std::array<std::size_t, lanes> cols{};
+    std::array<std::size_t, lanes> rows{};
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      cols[lane] = (k + lane) % grid;
+      rows[lane] = (k + lane) / grid;
+    }
+    packets.push_back(camera_table.get_rays(cols, rows, camera_table.offset(0.0, 0.0), active));
+  }
+
+  std::size_t hits = 0;
+  const double ns = time_ns([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      for (const auto& packet : packets) {
+        std::array<double, lanes> t_max{};
+        t_max.fill(std::numeric_limits<double>::infinity());
+        rt::lane_mask<lanes> mask{};
+        s.hit(packet.soa(), 0.001, t_max, mask);
+        for (const bool h : mask) {
+          if (h) {
+            hits += 1;
+          }
+        }
+        do_not_optimise(t_max);
+      }
+    }
+  });
+
+  const auto tests = static_cast<double>(repeats * grid * grid);
+  std::cout << "sphere::hit x16  " << ns / tests << " ns/test (" << hits << " hits)\n";
+}
+
+// primary ray setup alone, per pixel uv through camera::get_ray against the per column and per row
+// tables, table build included
+template <std::size_t W, std::size_t H> void bench_ray_setup(const std::uint32_t spp) {
+  constexpr std::size_t repeats = 8;
+
+  const auto cam = rt::camera_for<W, H>();
+  const auto rays = static_cast<double>(repeats * W * H * spp);
+
+  // one row at a time s.t. the stores stay in cache
+  std::vector<rt::vec3<double>> directions(W);
+  const double direct_ns = time_ns([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      for (std::uint32_t s = 0; s < spp; ++s) {
+        const auto du = rt::radical_inverse<double>(2, s);
+        const auto dv = rt::radical_inverse<double>(3, s);
+        for (std::size_t row = 0; row < H; ++row) {
+          for (std::size_t col = 0; col < W; ++col) {
+            const auto u = (static_cast<double>(col) + du) / static_cast<double>(W - 1);
+            const auto v = (static_cast<double>(row) + dv) / static_cast<double>(H - 1);
+            directions[col] = cam.get_ray(u, v).direction();
+          }
+          do_not_optimise(directions.data());
+        }
+      }
+    }
+  });
+
+  const double table_ns = time_ns([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      const rt::camera_rays<W, H> table{cam};
+      for (std::uint32_t s = 0; s < spp; ++s) {
+        const auto offset = table.offset(rt::radical_inverse<double>(2, s),
+                                         rt::radical_inverse<double>(3, s));
+        for (std::size_t row = 0; row < H; ++row) {
+          for (std::size_t col = 0; col < W; ++col) {
+            directions[col] = table.get_ray(col, row, offset).direction();
+          }
+          do_not_optimise(directions.data());
+        }
+      }
+    }
+  });
+
+  std::cout << "ray setup get_ray " << direct_ns / rays << " ns/ray, table " << table_ns / rays
+            << " ns/ray\n";
+}
+
+template <std::size_t W, std::size_t H, typename Scene>
+void bench_frame(const char* scene_name, const Scene& world, const std::uint32_t spp) {
+  constexpr std::size_t repeats = 8;
+
+  const auto cam = rt::camera_for<W, H>();
+  const auto tiles = rt::cull_tiles<W, H, rt::default_tile_size>(cam, world);
+  const rt::render_settings settings{spp};
+  std::vector<rt::pixel_u8> pixels(W * H);
+
+  const double ns = time_ns([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      const rt::camera_rays<W, H> rays{cam};
+      rt::render_rect<W, H, rt::default_tile_size>(
+          rays, world, tiles,
+          rt::image_rect{0, 0, static_cast<std::uint32_t>(W), static_cast<std::uint32_t>(H)},
+          settings, pixels);
+      do_not_optimise(pixels.data());
+    }
+  });
+
+  const auto rays = static_cast<double>(repeats * W * H * spp);
+  std::cout << "frame " << scene_name << " " << W << "x" << H << " @" << spp << "spp "
+            << ns / repeats / 1e6 << " ms/frame, " << rays / ns * 1e3 << " Mrays/s\n";
+}
+
+template <std::size_t W, std::size_t H, typename Scene>
+void bench_wavefront(const char* scene_name, const Scene& world, const std::uint32_t spp) {
+  constexpr std::size_t repeats = 8;
+
+  const auto cam = rt::camera_for<W, H>();
+  const rt::render_settings settings{spp};
+
+  const double ns = time_ns([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      const auto img = rt::wavefront::render<W, H>(world, cam, settings);
+      do_not_optimise(img.pixels().data());
+    }
+  });
+
+  const auto rays = static_cast<double>(repeats * W * H * spp);
+  std::cout << "wavefront " << scene_name << " " << W << "x" << H << " @" << spp << "spp "
+            << ns / repeats / 1e6 << " ms/frame, " << rays / ns * 1e3 << " Mrays/s\n";
+}
+
+template <std::size_t W, std::size_t H, typename Scene>
+void bench_packets(const char* scene_name, const Scene& world, const std::uint32_t spp) {
+  constexpr std::size_t repeats = 8;
+
+  const auto cam = rt::camera_for<W, H>();
+  const rt::render_settings settings{spp};
+
+  const double ns = time_ns([&] {
+    for (std::size_t r = 0; r < repeats; ++r) {
+      const auto img = rt::packet::render<W, H>(world, cam, settings);
+      do_not_optimise(img.pixels().data());
+    }
+  });
+
+  const auto rays = static_cast<double>(repeats * W * H * spp);
+  std::cout << "packets " << scene_name << " " << W << "x" << H << " @" << spp << "spp "
+            << ns / repeats / 1e6 << " ms/frame, " << rays / ns * 1e3 << " Mrays/s\n";
+}
+
+// full frame through render_rect
+template <std::size_t W, std::size_t H, typename Scene>
+auto render_frame(const Scene& world, const std::uint32_t spp) -> std::vector<rt::pixel_u8> {
+  const auto cam = rt::camera_for<W, H>();
+  const rt::camera_rays<W, H> rays{cam};
+  const auto tiles = rt::cull_tiles<W, H, rt::default_tile_size>(cam, world);
+  std::vector<rt::pixel_u8> pixels(W * H);
+  rt::render_rect<W, H, rt::default_tile_size>(
+      rays, world, tiles,
+      rt::image_rect{0, 0, static_cast<std::uint32_t>(W), static_cast<std::uint32_t>(H)},
+      rt::render_settings{spp}, pixels);
+  return pixels;
+}
+
+auto rmse(const std::vector<rt::pixel_u8>& a, const std::vector<rt::pixel_u8>& b) -> double {
+  double sum = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    const auto sq = [](const std::uint8_t x, const std::uint8_t y) {
+      const double d = static_cast<double>(x) - static_cast<double>(y);
+      return d * d;
+    };
+    sum += sq(a[i].r(), b[i].r()) + sq(a[i].g(), b[i].g()) + sq(a[i].b(), b[i].b());
+  }
+  return std::sqrt(sum / static_cast<double>(3 * a.size()));
+}
+
+// noise of one light sample per camera ray against a high spp reference, same time per frame
+// either way as the table lookup is O(1)... lower is better
+template <std::size_t W, std::size_t H> void bench_light_selection(const std::uint32_t spp) {
+  constexpr std::uint32_t reference_spp = 1024;
+
+  const auto power = rt::build_many_light_scene();
+  auto uniform = power;
+  uniform.build_light_table(rt::light_selection::uniform);
+
+  const auto reference = render_frame<W, H>(power, reference_spp);
+  const auto report = [&](const char* name, const auto& world) {
+    std::vector<rt::pixel_u8> pixels;
+    const double ns = time_ns([&] { pixels = render_frame<W, H>(world, spp); });
+    std::cout << "lights " << rt::many_light_count << " " << name << " @" << spp << "spp rmse "
+              << rmse(pixels, reference) << ", " << ns / 1e6 << " ms/frame\n";
+  };
+  report("power  ", power);
+  report("uniform", uniform);
+}
+
+} // namespace
+
+auto main() -> int {
+  bench_sphere_hit();
+  bench_sphere_hit_packet();
+  bench_ray_setup<640, 480>(4);
+  const auto spheres = rt::build_scene();
+  const auto lit = rt::build_many_light_scene();
+  bench_frame<640, 480>("spheres", spheres, 4);
+  bench_wavefront<640, 480>("spheres", spheres, 4);
+  bench_packets<640, 480>("spheres", spheres, 4);
+  bench_frame<640, 480>("lit", lit, 4);
+  bench_wavefront<640, 480>("lit", lit, 4);
+  bench_packets<640, 480>("lit", lit, 4);
+  bench_light_selection<160, 120>(4);
+  return 0;
+}
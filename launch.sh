@@ -3,9 +3,12 @@
 WARNINGS="-Wall -Wextra -Wpedantic -Wshadow -Wnon-virtual-dtor -Wold-style-cast \
   -Wunused -Wcast-align -Wconversion -Wsign-conversion -Wdouble-promotion \
   -Wimplicit-fallthrough -pedantic"
+
+# nothing reads errno after maths calls, and setting it keeps loops calling sqrt from vectorising
+FLAGS="-O3 -fno-math-errno"
   
 echo "formatting..."
-clang-format -i src/*.hpp src/*.cpp
+clang-format -i src/*.hpp src/*.cpp bench/*.cpp
 
 echo "tidying..."
 #clang-tidy \
@@ -13,7 +16,10 @@ echo "tidying..."
 #  -- -I./src -std=c++23 -fconstexpr-steps=80000000
 
 echo "building..."
-clang++ -std=c++23 -o bin/main ./src/*.cpp -I./src/ $WARNINGS -O3 -fconstexpr-steps=200000000
+clang++ -std=c++23 -o bin/main ./src/*.cpp -I./src/ $WARNINGS $FLAGS -fconstexpr-steps=200000000
+
+echo "building benchmarks..."
+clang++ -std=c++23 -o bin/bench ./bench/*.cpp -I./src/ $WARNINGS $FLAGS
 
 # echo "running..."
 # ./bin/main
@@ -0,0 +1,159 @@
+#ifndef ALIAS_TABLE_HPP
+#define ALIAS_TABLE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <span>
+
+namespace rt {
+
+// walker's alias method with vose's construction, O(n) to build and O(1) to draw an index with
+// probability proportional to its weight... everything is constexpr s.t. compile time scenes get
+// their tables built at compile time
+template <std::floating_point T, std::size_t N> class alias_table {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  struct sample_type {
+    size_type index;
+    // probability that index was drawn
+    value_type pmf;
+  };
+
+  [[nodiscard]] constexpr alias_table() noexcept = default;
+
+  // weights must be non-negative with a positive sum
+  [[nodiscard]] constexpr explicit alias_table(const std::span<const value_type> weights) noexcept
+      : m_size{weights.size()} {
+    assert(weights.size() <= N && "alias table capacity exceeded");
+
+    value_type total{};
+    for (const auto w : weights) {
+      assert(w >= value_type{0} && "alias table weights must be non-negative");
+      total += w;
+    }
+    assert(total > value_type{0} && "alias table needs a positive total weight");
+
+    // scale s.t. the average bucket holds exactly 1, then pair each underfull bucket with an
+    // overfull one that tops it up
+    std::array<value_type, N> scaled{};
+    std::array<size_type, N> small{};
+    std::array<size_type, N> large{};
+    size_type small_count = 0;
+    size_type large_count = 0;
+
+    const auto n = static_cast<value_type>(m_size);
+    for (size_type i = 0; i < m_size; ++i) {
+      m_pmf[i] = weights[i] / total;
+      scaled[i] = m_pmf[i] * n;
+      if (scaled[i] < value_type{1}) {
+        small[small_count++] = i;
+      } else {
+        large[large_count++] = i;
+      }
+    }
+
+    while (small_count > 0 && large_count > 0) {
+      const size_type s = small[--small_count];
+      const size_type l = large[--large_count];
+      m_prob[s] = scaled[s];
+      m_alias[s] = l;
+      scaled[l] = (scaled[l] + scaled[s]) - value_type{1};
+      if (scaled[l] < value_type{1}) {
+        small[small_count++] = l;
+      } else {
+        large[large_count++] = l;
+      }
+    }
+
+    // whatever is left is full up to rounding error
+    while (large_count > 0) {
+      const size_type l = large[--large_count];
+      m_prob[l] = value_type{1};
+      m_alias[l] = l;
+    }
+    while (small_count > 0) {
+      const size_type s = small[--small_count];
+      m_prob[s] = value_type{1};
+      m_alias[s] = s;
+    }
+  }
+
+  // u is uniform in [0, 1), one uniform picks both the bucket and the side of it
+  [[nodiscard]] constexpr auto sample(const value_type u) const noexcept -> sample_type {
+    assert(m_size > 0 && "sampling an empty alias table");
+    const value_type scaled = u * static_cast<value_type>(m_size);
+    const size_type bucket = std::min(static_cast<size_type>(scaled), m_size - 1);
+    const value_type side = scaled - static_cast<value_type>(bucket);
+    const size_type index = side < m_prob[bucket] ? bucket : m_alias[bucket];
+    return {index, m_pmf[index]};
+  }
+
+  [[nodiscard]] constexpr auto pmf(const size_type i) const noexcept -> value_type {
+    assert(i < m_size && "alias table index out of range");
+    return m_pmf[i];
+  }
+
+  [[nodiscard]] constexpr auto size() const noexcept -> size_type {
+    return m_size;
+  }
+  [[nodiscard]] constexpr auto empty() const noexcept -> bool {
+    return m_size == 0;
+  }
+
+private:
+  std::array<value_type, N> m_prob{};
+  std::array<size_type, N> m_alias{};
+  std::array<value_type, N> m_pmf{};
+  size_type m_size{};
+};
+
+namespace detail {
+
+// weights 1, 2, 3, 2 worked through by hand... buckets 1 and 2 come out full, bucket 0 is split
+// half way with 3 and bucket 3 half way with 2. every value below is exact in binary
+[[nodiscard]] consteval auto alias_table_draws_as_built() noexcept -> bool {
+  constexpr std::array weights{1.0, 2.0, 3.0, 2.0};
+  const alias_table<double, 4> table{weights};
+
+  constexpr std::array pmfs{0.125, 0.25, 0.375, 0.25};
+  double total{};
+  for (std::size_t i = 0; i < pmfs.size(); ++i) {
+    if (table.pmf(i) != pmfs[i]) {
+      return false;
+    }
+    total += table.pmf(i);
+  }
+
+  // either side of every bucket boundary and every split
+  struct draw {
+    double u;
+    std::size_t index;
+  };
+  constexpr std::array draws{
+      // bucket 0, 3 past the split
+      draw{0.0, 0}, draw{0.0625, 0}, draw{0.125, 3}, draw{0.2490234375, 3},
+      // buckets 1 and 2, no split
+      draw{0.25, 1}, draw{0.4990234375, 1}, draw{0.5, 2}, draw{0.7490234375, 2},
+      // bucket 3, 2 past the split
+      draw{0.75, 3}, draw{0.8740234375, 3}, draw{0.875, 2}, draw{0.9990234375, 2}};
+  for (const auto [u, index] : draws) {
+    const auto s = table.sample(u);
+    if (s.index != index || s.pmf != pmfs[index]) {
+      return false;
+    }
+  }
+  return total == 1.0;
+}
+
+} // namespace detail
+
+static_assert(detail::alias_table_draws_as_built());
+
+} // namespace rt
+
+#endif // ALIAS_TABLE_HPP
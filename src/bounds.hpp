@@ -0,0 +1,29 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <concepts>
+
+#include "point3.hpp"
+#include "ray.hpp"
+#include "util.hpp"
+
+namespace rt {
+
+// conservative bounding volume, a sphere is cheap to test against planes...
+template <ray_value_type_compatible T> struct bounding_sphere {
+  using value_type = T;
+
+  point3<T> center;
+  T radius;
+};
+
+// for objects that can report their bounds, required for culling
+template <typename T>
+concept boundable = requires(const T obj) {
+  typename extracted_value_type_of_t<T>;
+  { obj.bounds() } -> std::same_as<bounding_sphere<extracted_value_type_of_t<T>>>;
+};
+
+} // namespace rt
+
+#endif // BOUNDS_HPP
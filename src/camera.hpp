@@ -1,31 +1,70 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include <array>
+#include <cassert>
+
 #include "point3.hpp"
 #include "ray.hpp"
+#include "util.hpp"
 #include "vec3.hpp"
 
 namespace rt {
 
+// where the camera sits and what it looks at, the aspect ratio comes from the image... the
+// defaults look down -z from the origin with a 90 degree vertical fov
+struct camera_settings {
+  point3_d look_from{0.0, 0.0, 0.0};
+  point3_d look_at{0.0, 0.0, -1.0};
+  vec3<double> up{0.0, 1.0, 0.0};
+  // vertical field of view in degrees, in (0, 180)
+  double vfov = 90.0;
+};
+
 class camera {
 public:
-  [[nodiscard]] constexpr camera() noexcept {
-    auto aspect_ratio = 16.0 / 9.0;
-    auto viewport_height = 2.0;
-    auto viewport_width = aspect_ratio * viewport_height;
-    auto focal_length = 1.0;
+  // square frame with the default settings, mostly s.t. camera stays default constructible
+  [[nodiscard]] constexpr camera() noexcept : camera{camera_settings{}, 1.0} {}
+
+  [[nodiscard]] constexpr camera(const camera_settings& settings,
+                                 const double aspect_ratio) noexcept {
+    assert(settings.vfov > 0.0 && settings.vfov < 180.0 && "vertical fov out of range");
+    assert(aspect_ratio > 0.0 && "aspect ratio must be positive");
 
-    m_origin = {0.0, 0.0, 0.0};
-    m_horizontal = {viewport_width, 0.0, 0.0};
-    m_vertical = {0.0, viewport_height, 0.0};
-    m_lower_left_corner =
-        m_origin - m_horizontal / 2.0 - m_vertical / 2.0 - vec3{0.0, 0.0, focal_length};
+    const auto viewport_height = 2.0 * tan_constexpr(degrees_to_radians(settings.vfov) / 2.0);
+    const auto viewport_width = aspect_ratio * viewport_height;
+
+    // orthonormal basis, w points back out of the screen
+    const auto back = settings.look_from - settings.look_at;
+    const auto side = cross(settings.up, back);
+    assert(side.length_squared() > 0.0 && "camera looks at itself or along its up vector");
+    const auto w = unit_vector(back);
+    const auto u = unit_vector(side);
+    const auto v = cross(w, u);
+
+    m_origin = settings.look_from;
+    m_horizontal = viewport_width * u;
+    m_vertical = viewport_height * v;
+    m_lower_left_corner = m_origin - m_horizontal / 2.0 - m_vertical / 2.0 - w;
   }
 
   [[nodiscard]] constexpr auto get_ray(const double u, const double v) const noexcept -> ray_d {
     return {m_origin, m_lower_left_corner + u * m_horizontal + v * m_vertical - m_origin};
   }
 
+  [[nodiscard]] constexpr auto origin() const noexcept -> point3_d {
+    return m_origin;
+  }
+  [[nodiscard]] constexpr auto lower_left_corner() const noexcept -> point3_d {
+    return m_lower_left_corner;
+  }
+  [[nodiscard]] constexpr auto horizontal() const noexcept -> vec3<double> {
+    return m_horizontal;
+  }
+  [[nodiscard]] constexpr auto vertical() const noexcept -> vec3<double> {
+    return m_vertical;
+  }
+
 private:
   point3_d m_origin;
   point3_d m_lower_left_corner;
@@ -33,6 +72,87 @@ private:
   vec3<double> m_vertical;
 };
 
+// camera whose aspect ratio matches a Width x Height image
+template <std::size_t Width, std::size_t Height>
+  requires((Width > 0) && (Height > 0))
+[[nodiscard]] constexpr auto camera_for(const camera_settings& settings = {}) noexcept -> camera {
+  return camera{settings, static_cast<double>(Width) / static_cast<double>(Height)};
+}
+
+// primary rays through a Width x Height frame... the direction through a pixel splits into a per
+// column and a per row term, both tabled once per frame, plus the sample's offset inside the
+// pixel. a ray costs two vector adds instead of two divides and a full multiply-add per axis
+template <std::size_t Width, std::size_t Height>
+  requires((Width > 1) && (Height > 1))
+class camera_rays {
+public:
+  [[nodiscard]] constexpr explicit camera_rays(const camera& cam) noexcept
+      : m_origin{cam.origin()},
+        m_pixel_horizontal{cam.horizontal() / static_cast<double>(Width - 1)},
+        m_pixel_vertical{cam.vertical() / static_cast<double>(Height - 1)} {
+    const vec3<double> corner = cam.lower_left_corner() - m_origin;
+    for (std::size_t col = 0; col < Width; ++col) {
+      m_columns[col] = corner + static_cast<double>(col) * m_pixel_horizontal;
+    }
+    for (std::size_t row = 0; row < Height; ++row) {
+      m_rows[row] = static_cast<double>(row) * m_pixel_vertical;
+    }
+  }
+
+  // a sample's offset inside its pixel, du and dv are in [0, 1)... the same for every pixel, so
+  // hoist it out of loops over pixels
+  [[nodiscard]] constexpr auto offset(const double du, const double dv) const noexcept
+      -> vec3<double> {
+    return du * m_pixel_horizontal + dv * m_pixel_vertical;
+  }
+
+  // col and row are in camera space (row 0 at the bottom)
+  [[nodiscard]] constexpr auto direction(const std::size_t col, const std::size_t row,
+                                         const vec3<double>& offset) const noexcept
+      -> vec3<double> {
+    assert(col < Width && row < Height && "pixel outside of the frame");
+    return m_columns[col] + m_rows[row] + offset;
+  }
+
+  [[nodiscard]] constexpr auto get_ray(const std::size_t col, const std::size_t row,
+                                       const vec3<double>& offset) const noexcept -> ray_d {
+    return {m_origin, direction(col, row, offset)};
+  }
+
+  // one ray per lane, all at the same offset inside their pixels... lanes that are off still get
+  // a ray but nothing should trace it
+  template <std::size_t N>
+  [[nodiscard]] constexpr auto get_rays(const std::array<std::size_t, N>& cols,
+                                        const std::array<std::size_t, N>& rows,
+                                        const vec3<double>& offset,
+                                        const lane_mask<N>& active) const noexcept
+      -> ray_packet<double, N> {
+    ray_packet<double, N> rays{};
+    for (std::size_t i = 0; i < N; ++i) {
+      const auto d = direction(cols[i], rows[i], offset);
+      rays.ox[i] = m_origin.x();
+      rays.oy[i] = m_origin.y();
+      rays.oz[i] = m_origin.z();
+      rays.dx[i] = d.x();
+      rays.dy[i] = d.y();
+      rays.dz[i] = d.z();
+    }
+    rays.active = active;
+    return rays;
+  }
+
+  [[nodiscard]] constexpr auto origin() const noexcept -> point3_d {
+    return m_origin;
+  }
+
+private:
+  point3_d m_origin;
+  vec3<double> m_pixel_horizontal;
+  vec3<double> m_pixel_vertical;
+  std::array<vec3<double>, Width> m_columns{};
+  std::array<vec3<double>, Height> m_rows{};
+};
+
 } // namespace rt
 
-#endif // CAMERA_H
\ No newline at end of file
+#endif // CAMERA_H
@@ -38,6 +38,12 @@ public:
     return colour<T>{c1.m_rgb + c2.m_rgb};
   }
 
+  // component-wise, i.e. filtering light by a surface colour
+  [[nodiscard]] friend constexpr auto operator*(const colour<T>& c1, const colour<T>& c2) noexcept
+      -> colour<T> {
+    return colour<T>{c1.m_rgb * c2.m_rgb};
+  }
+
   [[nodiscard]] friend constexpr auto operator*(const T t, const colour<T>& c) noexcept
       -> colour<T> {
     return colour<T>{t * c.m_rgb};
@@ -0,0 +1,516 @@
+#ifndef FARM_HPP
+#define FARM_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "camera.hpp"
+#include "frustum.hpp"
+#include "image.hpp"
+#include "pixel.hpp"
+#include "render.hpp"
+#include "scene.hpp"
+
+// coordinator/worker render farm, the coordinator splits a frame into tile jobs and hands them to
+// worker processes over local sockets, workers stream the finished tiles back...
+//
+// every message is a message_header followed by payload_size bytes:
+//   frame    - coordinator -> worker, a frame_payload<Scene>, once before any job
+//   job      - coordinator -> worker, the image_rect to render
+//   tile     - worker -> coordinator, the job's image_rect then rgb bytes row by row
+//   shutdown - coordinator -> worker, no payload
+//
+// payloads are the raw bytes of trivially copyable types, so both ends must be the same build
+
+namespace rt::farm {
+
+inline constexpr std::uint32_t protocol_magic = 0x52544652; // "RTFR"
+
+enum class message_type : std::uint32_t {
+  job = 1,
+  tile = 2,
+  shutdown = 3,
+  frame = 4,
+};
+
+struct message_header {
+  std::uint32_t magic;
+  message_type type;
+  std::uint32_t job_id;
+  std::uint32_t payload_size;
+};
+
+// everything a worker needs to render any part of the frame, jobs then only say which part
+template <typename Scene> struct frame_payload {
+  Scene world;
+  camera cam;
+  render_settings settings;
+};
+
+struct farm_settings {
+  std::size_t workers = 4;
+  // jobs are square tiles of this many pixels
+  std::uint32_t job_size = 32;
+  // a worker still on the same job after this long is presumed hung, it gets killed and its job
+  // goes to another worker
+  std::chrono::milliseconds job_timeout{30000};
+  // worker 0 exits after this many jobs, only for exercising job reissue...
+  std::optional<std::size_t> crash_after_jobs;
+  // worker 0 stops responding after this many jobs, only for exercising the job timeout
+  std::optional<std::size_t> hang_after_jobs;
+};
+
+namespace detail {
+
+using clock = std::chrono::steady_clock;
+
+// the coordinator's ends of the sockets are non-blocking s.t. a worker that stops part way through
+// a message can't stall it, every send and receive on them waits through poll until a deadline...
+// the workers' ends block and never get past the first wait, they have no deadline
+
+// false once the deadline passes before fd is ready
+[[nodiscard]] inline auto wait_ready(const int fd, const short events,
+                                     const clock::time_point deadline) noexcept -> bool {
+  for (;;) {
+    // rounded up s.t. the deadline has passed when poll gives up
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now());
+    if (wait.count() <= 0) {
+      return false;
+    }
+    pollfd p{fd, events, 0};
+    const int ready = ::poll(&p, 1,
+                             static_cast<int>(std::min<std::chrono::milliseconds::rep>(
+                                 wait.count(), std::numeric_limits<int>::max())));
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    // hangups and errors count as ready, the send or recv after reports them
+    return ready > 0;
+  }
+}
+
+// false when the peer has gone away or the deadline passes
+[[nodiscard]] inline auto send_all(const int fd, std::span<const std::byte> bytes,
+                                   const clock::time_point deadline = clock::time_point::max())
+    noexcept -> bool {
+  while (!bytes.empty()) {
+    const auto sent = ::send(fd, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_ready(fd, POLLOUT, deadline)) {
+        continue;
+      }
+      return false;
+    }
+    bytes = bytes.subspan(static_cast<std::size_t>(sent));
+  }
+  return true;
+}
+
+// false on eof, error or the deadline passing, a partial read is as good as a dead peer
+[[nodiscard]] inline auto recv_all(const int fd, std::span<std::byte> bytes,
+                                   const clock::time_point deadline = clock::time_point::max())
+    noexcept -> bool {
+  while (!bytes.empty()) {
+    const auto got = ::recv(fd, bytes.data(), bytes.size(), 0);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_ready(fd, POLLIN, deadline)) {
+        continue;
+      }
+      return false;
+    }
+    if (got == 0) {
+      return false;
+    }
+    bytes = bytes.subspan(static_cast<std::size_t>(got));
+  }
+  return true;
+}
+
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+[[nodiscard]] inline auto send_value(const int fd, const T& value,
+                                     const clock::time_point deadline = clock::time_point::max())
+    noexcept -> bool {
+  return send_all(fd, std::as_bytes(std::span{&value, 1}), deadline);
+}
+
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+[[nodiscard]] inline auto recv_value(const int fd, T& value,
+                                     const clock::time_point deadline = clock::time_point::max())
+    noexcept -> bool {
+  return recv_all(fd, std::as_writable_bytes(std::span{&value, 1}), deadline);
+}
+
+[[nodiscard]] inline auto send_message(const int fd, const message_type type,
+                                       const std::uint32_t job_id,
+                                       const std::span<const std::byte> payload,
+                                       const clock::time_point deadline = clock::time_point::max())
+    noexcept -> bool {
+  const message_header header{protocol_magic, type, job_id,
+                              static_cast<std::uint32_t>(payload.size())};
+  return send_value(fd, header, deadline) && send_all(fd, payload, deadline);
+}
+
+// tiles go over the wire as their rect followed by packed rgb...
+[[nodiscard]] inline auto encode_tile(const image_rect rect, const std::span<const pixel_u8> pixels)
+    -> std::vector<std::byte> {
+  std::vector<std::byte> bytes(sizeof(image_rect) + pixels.size() * 3);
+  std::memcpy(bytes.data(), &rect, sizeof(image_rect));
+  auto* out = bytes.data() + sizeof(image_rect);
+  for (const auto& px : pixels) {
+    *out++ = static_cast<std::byte>(px.r());
+    *out++ = static_cast<std::byte>(px.g());
+    *out++ = static_cast<std::byte>(px.b());
+  }
+  return bytes;
+}
+
+template <std::size_t W, std::size_t H>
+[[nodiscard]] inline auto decode_tile(const std::span<const std::byte> bytes, image<W, H>& img)
+    -> bool {
+  if (bytes.size() < sizeof(image_rect)) {
+    return false;
+  }
+  image_rect rect{};
+  std::memcpy(&rect, bytes.data(), sizeof(image_rect));
+  if (rect.x0 > rect.x1 || rect.y0 > rect.y1 || rect.x1 > W || rect.y1 > H ||
+      bytes.size() != sizeof(image_rect) + rect.size() * 3) {
+    return false;
+  }
+
+  const auto* in = bytes.data() + sizeof(image_rect);
+  for (std::size_t y = rect.y0; y < rect.y1; ++y) {
+    for (std::size_t x = rect.x0; x < rect.x1; ++x) {
+      img.set_pixel(x, y,
+                    pixel_u8{std::to_integer<std::uint8_t>(in[0]),
+                             std::to_integer<std::uint8_t>(in[1]),
+                             std::to_integer<std::uint8_t>(in[2])});
+      in += 3;
+    }
+  }
+  return true;
+}
+
+struct worker {
+  pid_t pid;
+  int fd;
+  std::optional<std::uint32_t> job;
+  // when the current job counts as hung
+  clock::time_point deadline;
+};
+
+// kills and reaps every worker still open when it goes out of scope, s.t. a throw part way through
+// a render leaks neither fds nor child processes
+class worker_guard {
+public:
+  explicit worker_guard(std::vector<worker>& workers) noexcept : m_workers{workers} {}
+  worker_guard(const worker_guard&) = delete;
+  auto operator=(const worker_guard&) -> worker_guard& = delete;
+
+  ~worker_guard() {
+    for (auto& w : m_workers) {
+      if (w.fd >= 0) {
+        ::kill(w.pid, SIGKILL);
+        ::close(w.fd);
+        w.fd = -1;
+        ::waitpid(w.pid, nullptr, 0);
+      }
+    }
+  }
+
+private:
+  std::vector<worker>& m_workers;
+};
+
+} // namespace detail
+
+// serves jobs from fd until shutdown or the coordinator goes away...
+template <std::size_t Width, std::size_t Height, std::size_t TileSize, boundable T, std::size_t N,
+          std::size_t L>
+  requires valid_image_dimensions<Width, Height>
+inline void run_worker(const int fd, const std::optional<std::size_t> crash_after_jobs,
+                       const std::optional<std::size_t> hang_after_jobs) {
+  using payload_type = frame_payload<scene<T, N, L>>;
+  using tiles_type = tile_candidates<Width, Height, TileSize, N>;
+  static_assert(std::is_trivially_copyable_v<payload_type>, "frames are sent as raw bytes");
+
+  // the culled tiles and the camera table are built once per frame and shared by all of its
+  // jobs... all on the heap, at large sizes the tiles alone don't fit on the stack
+  std::unique_ptr<payload_type> frame;
+  std::unique_ptr<const tiles_type> tiles;
+  std::unique_ptr<const camera_rays<Width, Height>> rays;
+  std::vector<pixel_u8> pixels;
+  std::size_t jobs_done = 0;
+
+  message_header header{};
+  while (detail::recv_value(fd, header)) {
+    if (header.magic != protocol_magic) {
+      return;
+    }
+
+    if (header.type == message_type::frame) {
+      if (header.payload_size != sizeof(payload_type)) {
+        return;
+      }
+      frame = std::make_unique<payload_type>();
+      if (!detail::recv_value(fd, *frame)) {
+        return;
+      }
+      // new straight from the prvalue, make_unique would take it by reference off the stack
+      tiles.reset(
+          new const tiles_type(cull_tiles<Width, Height, TileSize>(frame->cam, frame->world)));
+      rays = std::make_unique<const camera_rays<Width, Height>>(frame->cam);
+      continue;
+    }
+
+    // a job before any frame has nothing to render against
+    if (header.type != message_type::job || header.payload_size != sizeof(image_rect) || !frame) {
+      return;
+    }
+    image_rect rect{};
+    if (!detail::recv_value(fd, rect)) {
+      return;
+    }
+
+    if (crash_after_jobs && jobs_done == *crash_after_jobs) {
+      ::_exit(1);
+    }
+    if (hang_after_jobs && jobs_done == *hang_after_jobs) {
+      for (;;) {
+        ::pause();
+      }
+    }
+
+    pixels.assign(rect.size(), pixel_u8{});
+    render_rect<Width, Height, TileSize>(*rays, frame->world, *tiles, rect, frame->settings,
+                                         pixels);
+
+    const auto bytes = detail::encode_tile(rect, pixels);
+    if (!detail::send_message(fd, message_type::tile, header.job_id, bytes)) {
+      return;
+    }
+    jobs_done += 1;
+  }
+}
+
+// renders the frame over settings.workers forked worker processes, jobs held by a worker that dies
+// or hangs past the job timeout are handed to the next idle one... throws if every worker fails
+// before the frame is done
+template <std::size_t Width, std::size_t Height, std::size_t TileSize = default_tile_size,
+          boundable T, std::size_t N, std::size_t L>
+  requires valid_image_dimensions<Width, Height>
+[[nodiscard]] inline auto render(const scene<T, N, L>& world, const camera& cam,
+                                 const render_settings& settings, const farm_settings& farm)
+    -> image<Width, Height> {
+  if (farm.workers == 0 || farm.job_size == 0 || farm.job_timeout.count() <= 0) {
+    throw std::invalid_argument(
+        "farm needs at least one worker, a non-empty job size and a positive job timeout");
+  }
+
+  using detail::clock;
+  using detail::worker;
+
+  // split the frame into jobs...
+  std::vector<image_rect> jobs;
+  for (std::uint32_t y = 0; y < Height; y += farm.job_size) {
+    for (std::uint32_t x = 0; x < Width; x += farm.job_size) {
+      jobs.push_back({x, y, std::min(x + farm.job_size, static_cast<std::uint32_t>(Width)),
+                      std::min(y + farm.job_size, static_cast<std::uint32_t>(Height))});
+    }
+  }
+  std::deque<std::uint32_t> pending;
+  for (std::uint32_t i = 0; i < jobs.size(); ++i) {
+    pending.push_back(i);
+  }
+
+  // spawn workers, each child only keeps its own end of its own socket
+  std::vector<worker> workers;
+  workers.reserve(farm.workers);
+  const detail::worker_guard guard{workers};
+  for (std::size_t i = 0; i < farm.workers; ++i) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      throw std::runtime_error(std::string{"failed to create worker socket - "} +
+                               std::strerror(errno));
+    }
+    // only the coordinator's end, the worker's own end stays blocking
+    if (::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK) != 0) {
+      const int error = errno;
+      ::close(fds[0]);
+      ::close(fds[1]);
+      throw std::runtime_error(std::string{"failed to set up worker socket - "} +
+                               std::strerror(error));
+    }
+
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+      const int error = errno;
+      ::close(fds[0]);
+      ::close(fds[1]);
+      throw std::runtime_error(std::string{"failed to fork worker - "} + std::strerror(error));
+    }
+    if (pid == 0) {
+      // never unwind into the parent's stack from here, the guard would kill the siblings
+      try {
+        ::close(fds[0]);
+        for (const auto& w : workers) {
+          ::close(w.fd);
+        }
+        const auto fault = [&](const std::optional<std::size_t>& after_jobs) {
+          return i == 0 ? after_jobs : std::optional<std::size_t>{};
+        };
+        run_worker<Width, Height, TileSize, T, N, L>(fds[1], fault(farm.crash_after_jobs),
+                                                     fault(farm.hang_after_jobs));
+      } catch (...) {
+        ::_exit(1);
+      }
+      ::_exit(0);
+    }
+
+    ::close(fds[1]);
+    workers.push_back({pid, fds[0], std::nullopt, {}});
+  }
+
+  // workers that may still be running, hung or stopped part way through a message, have to be
+  // killed first, waitpid would wait on them forever
+  const auto retire = [&](worker& w, const bool running = false) {
+    if (running) {
+      ::kill(w.pid, SIGKILL);
+    }
+    if (w.job) {
+      pending.push_front(*w.job);
+      w.job.reset();
+    }
+    ::close(w.fd);
+    w.fd = -1;
+    ::waitpid(w.pid, nullptr, 0);
+  };
+
+  // the scene, camera and settings go to every worker once, jobs are only rects after that
+  const frame_payload<scene<T, N, L>> frame{world, cam, settings};
+  for (auto& w : workers) {
+    if (!detail::send_message(w.fd, message_type::frame, 0, std::as_bytes(std::span{&frame, 1}),
+                              clock::now() + farm.job_timeout)) {
+      retire(w, true);
+    }
+  }
+
+  // on the heap, at large sizes the image in this frame plus a worker's tables forked off it
+  // overflow the stack
+  const auto img = std::make_unique<image<Width, Height>>();
+  std::size_t remaining = jobs.size();
+  std::vector<std::byte> payload;
+
+  while (remaining > 0) {
+    // hand out work to idle workers
+    for (auto& w : workers) {
+      if (w.fd < 0 || w.job || pending.empty()) {
+        continue;
+      }
+      const auto id = pending.front();
+      pending.pop_front();
+      w.job = id;
+      w.deadline = clock::now() + farm.job_timeout;
+      if (!detail::send_message(w.fd, message_type::job, id,
+                                std::as_bytes(std::span{&jobs[id], 1}), w.deadline)) {
+        retire(w, true);
+      }
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<worker*> polled;
+    auto next_deadline = clock::time_point::max();
+    for (auto& w : workers) {
+      if (w.fd >= 0 && w.job) {
+        fds.push_back({w.fd, POLLIN, 0});
+        polled.push_back(&w);
+        next_deadline = std::min(next_deadline, w.deadline);
+      }
+    }
+    if (fds.empty()) {
+      if (std::ranges::none_of(workers, [](const worker& w) { return w.fd >= 0; })) {
+        throw std::runtime_error("every farm worker failed before the frame was done");
+      }
+      continue;
+    }
+
+    // wake up for the earliest deadline even if nothing arrives, rounded up s.t. it has passed
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(next_deadline - clock::now());
+    const auto timeout = static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(
+        wait.count(), 0, std::numeric_limits<int>::max()));
+    if (::poll(fds.data(), fds.size(), timeout) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string{"failed to poll workers - "} + std::strerror(errno));
+    }
+
+    const auto now = clock::now();
+    for (std::size_t i = 0; i < fds.size(); ++i) {
+      auto& w = *polled[i];
+      if (fds[i].revents == 0) {
+        if (now >= w.deadline) {
+          retire(w, true);
+        }
+        continue;
+      }
+
+      // the rest of the message has until the job's deadline to turn up
+      message_header header{};
+      if (!detail::recv_value(w.fd, header, w.deadline) || header.magic != protocol_magic ||
+          header.type != message_type::tile || header.job_id != w.job) {
+        retire(w, true);
+        continue;
+      }
+      payload.resize(header.payload_size);
+      if (!detail::recv_all(w.fd, payload, w.deadline) || !detail::decode_tile(payload, *img)) {
+        retire(w, true);
+        continue;
+      }
+
+      w.job.reset();
+      remaining -= 1;
+    }
+  }
+
+  for (auto& w : workers) {
+    if (w.fd >= 0) {
+      // no waiting on a worker that can't take it right away, it gets killed instead
+      const bool sent = detail::send_message(w.fd, message_type::shutdown, 0, {}, clock::now());
+      retire(w, !sent);
+    }
+  }
+
+  return *img;
+}
+
+} // namespace rt::farm
+
+#endif // FARM_HPP
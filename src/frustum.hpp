@@ -0,0 +1,145 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+#include "bounds.hpp"
+#include "camera.hpp"
+#include "image.hpp"
+#include "point3.hpp"
+#include "ray.hpp"
+#include "scene.hpp"
+#include "vec3.hpp"
+
+namespace rt {
+
+// pyramid of primary rays leaving the camera through some part of the frame, bounded by four planes
+// that all pass through the apex...
+template <ray_value_type_compatible T> class frustum {
+public:
+  using value_type = T;
+
+  // edge directions go around the frustum in order, winding does not matter
+  [[nodiscard]] constexpr frustum(const point3<value_type> apex,
+                                  const std::array<vec3<value_type>, 4>& edges) noexcept
+      : m_apex{apex} {
+    vec3<value_type> axis{};
+    for (const auto& e : edges) {
+      axis += e;
+    }
+
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+      auto n = unit_vector(cross(edges[i], edges[(i + 1) % edges.size()]));
+      // make every normal point inwards...
+      if (dot(n, axis) < value_type{0}) {
+        n = -n;
+      }
+      m_normals[i] = n;
+    }
+  }
+
+  // conservative, may report bounds that only graze a corner of the frustum
+  [[nodiscard]] constexpr auto intersects(const bounding_sphere<value_type>& b) const noexcept
+      -> bool {
+    const vec3<value_type> to_center = b.center - m_apex;
+    return std::ranges::all_of(m_normals, [&](const vec3<value_type>& n) constexpr noexcept {
+      return dot(n, to_center) >= -b.radius;
+    });
+  }
+
+private:
+  point3<value_type> m_apex;
+  std::array<vec3<value_type>, 4> m_normals{};
+};
+
+template <std::size_t Width, std::size_t Height, std::size_t TileSize>
+  requires(valid_image_dimensions<Width, Height> && (TileSize > 0))
+struct tile_grid {
+  static constexpr std::size_t tile_size = TileSize;
+  static constexpr std::size_t tiles_x = (Width + TileSize - 1) / TileSize;
+  static constexpr std::size_t tiles_y = (Height + TileSize - 1) / TileSize;
+  static constexpr std::size_t count = tiles_x * tiles_y;
+
+  // col and row are in camera space, row 0 is the bottom of the frame
+  [[nodiscard]] static constexpr auto tile_of(const std::size_t col, const std::size_t row) noexcept
+      -> std::size_t {
+    return (row / TileSize) * tiles_x + col / TileSize;
+  }
+};
+
+// indices of the scene objects that might be hit by rays through a tile
+template <std::size_t N> class candidate_list {
+public:
+  using size_type = std::size_t;
+
+  [[nodiscard]] constexpr candidate_list() noexcept = default;
+
+  constexpr void push(const size_type index) noexcept {
+    assert(m_count < N && "candidate list capacity exceeded");
+    m_indices[m_count] = index;
+    m_count += 1;
+  }
+
+  [[nodiscard]] constexpr auto indices() const noexcept -> std::span<const size_type> {
+    return std::span<const size_type>{m_indices.data(), m_count};
+  }
+
+private:
+  std::array<size_type, N> m_indices{};
+  size_type m_count{};
+};
+
+template <std::size_t Width, std::size_t Height, std::size_t TileSize, std::size_t N>
+using tile_candidates = std::array<candidate_list<N>, tile_grid<Width, Height, TileSize>::count>;
+
+// pre-pass, find the objects whose bounds intersect each tile's primary ray frustum s.t. primary
+// rays only have to test those...
+template <std::size_t Width, std::size_t Height, std::size_t TileSize, boundable T, std::size_t N,
+          std::size_t L>
+  requires(valid_image_dimensions<Width, Height> && (Width > 1) && (Height > 1))
+[[nodiscard]] constexpr auto cull_tiles(const camera& cam, const scene<T, N, L>& world) noexcept
+    -> tile_candidates<Width, Height, TileSize, N> {
+  using grid = tile_grid<Width, Height, TileSize>;
+  using float_type = extracted_value_type_of_t<T>;
+
+  tile_candidates<Width, Height, TileSize, N> tiles{};
+  const auto objects = world.objects();
+
+  for (std::size_t ty = 0; ty < grid::tiles_y; ++ty) {
+    for (std::size_t tx = 0; tx < grid::tiles_x; ++tx) {
+      // the far edge reaches one pixel past the tile's last column and row, s.t. samples offset
+      // anywhere inside a pixel are still covered
+      const auto c0 = tx * TileSize;
+      const auto c1 = std::min(c0 + TileSize, Width);
+      const auto r0 = ty * TileSize;
+      const auto r1 = std::min(r0 + TileSize, Height);
+
+      const auto u0 = static_cast<double>(c0) / static_cast<double>(Width - 1);
+      const auto u1 = static_cast<double>(c1) / static_cast<double>(Width - 1);
+      const auto v0 = static_cast<double>(r0) / static_cast<double>(Height - 1);
+      const auto v1 = static_cast<double>(r1) / static_cast<double>(Height - 1);
+
+      const frustum<float_type> f{cam.origin(),
+                                  {cam.get_ray(u0, v0).direction(), cam.get_ray(u1, v0).direction(),
+                                   cam.get_ray(u1, v1).direction(),
+                                   cam.get_ray(u0, v1).direction()}};
+
+      auto& candidates = tiles[ty * grid::tiles_x + tx];
+      for (std::size_t i = 0; i < objects.size(); ++i) {
+        if (f.intersects(objects[i].bounds())) {
+          candidates.push(i);
+        }
+      }
+    }
+  }
+
+  return tiles;
+}
+
+} // namespace rt
+
+#endif // FRUSTUM_HPP
@@ -21,6 +21,24 @@ template <std::size_t W, std::size_t H> struct image_dimensions {
   static constexpr std::size_t size = W * H;
 };
 
+// half open region of an image, [x0, x1) x [y0, y1) with y0 at the top...
+struct image_rect {
+  std::uint32_t x0;
+  std::uint32_t y0;
+  std::uint32_t x1;
+  std::uint32_t y1;
+
+  [[nodiscard]] constexpr auto width() const noexcept -> std::size_t {
+    return x1 - x0;
+  }
+  [[nodiscard]] constexpr auto height() const noexcept -> std::size_t {
+    return y1 - y0;
+  }
+  [[nodiscard]] constexpr auto size() const noexcept -> std::size_t {
+    return width() * height();
+  }
+};
+
 template <std::size_t W, std::size_t H>
 concept valid_image_dimensions =
     (W > 0) && (H > 0) && (W * H <= std::numeric_limits<std::size_t>::max() / 3);
@@ -0,0 +1,41 @@
+#ifndef LIGHT_HPP
+#define LIGHT_HPP
+
+#include "colour.hpp"
+#include "point3.hpp"
+#include "ray.hpp"
+
+namespace rt {
+
+// isotropic point emitter, intensity is radiant intensity per channel
+template <ray_value_type_compatible T> class point_light {
+public:
+  using value_type = T;
+
+  [[nodiscard]] constexpr point_light() noexcept = default;
+  [[nodiscard]] constexpr point_light(const point3<value_type>& position,
+                                      const colour<value_type>& intensity) noexcept
+      : m_position{position}, m_intensity{intensity} {}
+
+  [[nodiscard]] constexpr auto position() const noexcept -> point3<value_type> {
+    return m_position;
+  }
+  [[nodiscard]] constexpr auto intensity() const noexcept -> colour<value_type> {
+    return m_intensity;
+  }
+
+  // total emitted power up to the constant 4 pi, what light selection is proportional to
+  [[nodiscard]] constexpr auto power() const noexcept -> value_type {
+    return (m_intensity.r() + m_intensity.g() + m_intensity.b()) / value_type{3};
+  }
+
+private:
+  point3<value_type> m_position;
+  colour<value_type> m_intensity;
+};
+
+using point_light_d = point_light<double>;
+
+} // namespace rt
+
+#endif // LIGHT_HPP
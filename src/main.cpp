@@ -1,18 +1,264 @@
 
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "farm.hpp"
+#include "packet.hpp"
+#include "progressive.hpp"
 #include "render.hpp"
+#include "wavefront.hpp"
 
 template <std::size_t W, std::size_t H> struct render_params {
   static constexpr std::size_t width = W;
   static constexpr std::size_t height = H;
 };
 
+struct options {
+  rt::render_settings settings;
+  // set when any camera option is given, the compile time image only uses the default view
+  std::optional<rt::camera_settings> view;
+  // runtime render over worker processes instead of the compile time image
+  std::optional<rt::farm::farm_settings> farm;
+  // runtime render that keeps flushing a preview while it converges
+  std::optional<rt::progressive::progressive_settings> progressive;
+  // runtime render through the batched wavefront pipeline
+  bool wavefront = false;
+  // runtime render tracing blocks of primary rays as packets
+  bool packets = false;
+  // runtime render of the scene lit by many point lights
+  bool many_lights = false;
+};
+
+template <typename T>
+[[nodiscard]] auto parse_number(const std::string_view s) -> std::optional<T> {
+  T value{};
+  const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+  if (ec != std::errc{} || ptr != s.data() + s.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// "x,y,z"
+[[nodiscard]] auto parse_vec3(const std::string_view s) -> std::optional<rt::vec3<double>> {
+  const auto first = s.find(',');
+  const auto second = s.find(',', first == std::string_view::npos ? first : first + 1);
+  if (first == std::string_view::npos || second == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const auto x = parse_number<double>(s.substr(0, first));
+  const auto y = parse_number<double>(s.substr(first + 1, second - first - 1));
+  const auto z = parse_number<double>(s.substr(second + 1));
+  if (!x || !y || !z) {
+    return std::nullopt;
+  }
+  return rt::vec3<double>{*x, *y, *z};
+}
+
+[[nodiscard]] auto parse_options(const std::span<char*> args) -> std::optional<options> {
+  options opts{};
+  for (std::size_t i = 1; i < args.size(); ++i) {
+    const std::string_view arg{args[i]};
+    const auto next = [&]() -> std::string_view {
+      return i + 1 < args.size() ? std::string_view{args[++i]} : std::string_view{};
+    };
+
+    if (arg == "--samples") {
+      const auto n = parse_number<std::uint32_t>(next());
+      if (!n || *n == 0) {
+        return std::nullopt;
+      }
+      opts.settings.samples_per_pixel = *n;
+    } else if (arg == "--farm") {
+      const auto n = parse_number<std::size_t>(next());
+      if (!n || *n == 0) {
+        return std::nullopt;
+      }
+      opts.farm = opts.farm.value_or(rt::farm::farm_settings{});
+      opts.farm->workers = *n;
+    } else if (arg == "--farm-hang") {
+      const auto n = parse_number<std::size_t>(next());
+      if (!n) {
+        return std::nullopt;
+      }
+      opts.farm = opts.farm.value_or(rt::farm::farm_settings{});
+      opts.farm->hang_after_jobs = *n;
+    } else if (arg == "--farm-timeout-ms") {
+      const auto n = parse_number<std::uint32_t>(next());
+      if (!n || *n == 0) {
+        return std::nullopt;
+      }
+      opts.farm = opts.farm.value_or(rt::farm::farm_settings{});
+      opts.farm->job_timeout = std::chrono::milliseconds{*n};
+    } else if (arg == "--farm-crash") {
+      const auto n = parse_number<std::size_t>(next());
+      if (!n) {
+        return std::nullopt;
+      }
+      opts.farm = opts.farm.value_or(rt::farm::farm_settings{});
+      opts.farm->crash_after_jobs = *n;
+    } else if (arg == "--progressive") {
+      opts.progressive = opts.progressive.value_or(rt::progressive::progressive_settings{});
+    } else if (arg == "--wavefront") {
+      opts.wavefront = true;
+    } else if (arg == "--packets") {
+      opts.packets = true;
+    } else if (arg == "--many-lights") {
+      opts.many_lights = true;
+    } else if (arg == "--look-from" || arg == "--look-at" || arg == "--up") {
+      const auto v = parse_vec3(next());
+      if (!v) {
+        return std::nullopt;
+      }
+      opts.view = opts.view.value_or(rt::camera_settings{});
+      if (arg == "--look-from") {
+        opts.view->look_from = rt::point3_d{*v};
+      } else if (arg == "--look-at") {
+        opts.view->look_at = rt::point3_d{*v};
+      } else {
+        opts.view->up = *v;
+      }
+    } else if (arg == "--vfov") {
+      const auto deg = parse_number<double>(next());
+      // written s.t. nan fails it too
+      if (!deg || !(*deg > 0.0 && *deg < 180.0)) {
+        return std::nullopt;
+      }
+      opts.view = opts.view.value_or(rt::camera_settings{});
+      opts.view->vfov = *deg;
+    } else if (arg == "--flush-ms") {
+      const auto n = parse_number<std::uint32_t>(next());
+      if (!n) {
+        return std::nullopt;
+      }
+      opts.progressive = opts.progressive.value_or(rt::progressive::progressive_settings{});
+      opts.progressive->flush_interval = std::chrono::milliseconds{*n};
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  // one runtime mode at most, the farm and progressive flags each imply their mode
+  const int modes = static_cast<int>(opts.farm.has_value()) +
+                    static_cast<int>(opts.progressive.has_value()) +
+                    static_cast<int>(opts.wavefront) + static_cast<int>(opts.packets);
+  if (modes > 1) {
+    return std::nullopt;
+  }
+
+  // the camera can't look at itself or straight along up, as the camera asserts... checked once
+  // every view flag is in as any of them can make or fix it. a nan anywhere fails too
+  if (opts.view) {
+    const auto side = rt::cross(opts.view->up, opts.view->look_from - opts.view->look_at);
+    if (!(side.length_squared() > 0.0)) {
+      return std::nullopt;
+    }
+  }
+  return opts;
+}
+
+// every runtime mode, for whichever scene... plain runtime rendering when no mode is picked
+template <typename Params, typename Scene>
+[[nodiscard]] auto render_runtime(const options& opts, const Scene& world) -> int {
+  constexpr std::size_t width = Params::width;
+  constexpr std::size_t height = Params::height;
+  const auto cam = rt::camera_for<width, height>(opts.view.value_or(rt::camera_settings{}));
+
+  if (opts.farm) {
+    try {
+      const auto farmed =
+          rt::farm::render<width, height>(world, cam, opts.settings, *opts.farm);
+      rt::dump_bytes(farmed);
+      rt::save_ppm(farmed, "out.ppm");
+    } catch (const std::exception& e) {
+      std::cerr << "farm render failed - " << e.what() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+
+  if (opts.progressive) {
+    // readers of out.ppm only ever see a complete preview...
+    const auto flush = [](const rt::image<width, height>& preview,
+                          const rt::progressive::progress& p) {
+      rt::save_ppm(preview, "out.ppm.tmp");
+      std::filesystem::rename("out.ppm.tmp", "out.ppm");
+      std::cerr << "pass " << p.pass << " - block " << p.block_size << ", "
+                << p.samples_per_pixel << " spp" << (p.done ? ", done" : "") << '\n';
+    };
+
+    try {
+      const auto refined = rt::progressive::render<width, height>(
+          world, cam, opts.settings, *opts.progressive, flush);
+      rt::dump_bytes(refined);
+    } catch (const std::exception& e) {
+      std::cerr << "progressive render failed - " << e.what() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+
+  if (opts.wavefront) {
+    const auto waved = rt::wavefront::render<width, height>(world, cam, opts.settings);
+    rt::dump_bytes(waved);
+    rt::save_ppm(waved, "out.ppm");
+    return 0;
+  }
+
+  if (opts.packets) {
+    const auto packed = rt::packet::render<width, height>(world, cam, opts.settings);
+    rt::dump_bytes(packed);
+    rt::save_ppm(packed, "out.ppm");
+    return 0;
+  }
+
+  const rt::camera_rays<width, height> rays{cam};
+  const auto tiles = rt::cull_tiles<width, height, rt::default_tile_size>(cam, world);
+  std::vector<rt::pixel_u8> pixels(width * height);
+  rt::render_rect<width, height, rt::default_tile_size>(
+      rays, world, tiles,
+      rt::image_rect{0, 0, static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height)},
+      opts.settings, pixels);
+
+  rt::image<width, height> img{};
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    img.set_pixel(i % width, i / width, pixels[i]);
+  }
+  rt::dump_bytes(img);
+  rt::save_ppm(img, "out.ppm");
+  return 0;
+}
+
 auto main(int argc, char* argv[]) -> int {
-  (void)argc;
-  (void)argv;
+  const auto opts = parse_options(std::span{argv, static_cast<std::size_t>(argc)});
+  if (!opts) {
+    std::cerr << "usage: main [--samples n] [--farm workers] [--farm-crash jobs] "
+                 "[--farm-hang jobs] [--farm-timeout-ms ms] [--progressive] [--flush-ms ms] "
+                 "[--wavefront] [--packets] [--many-lights] [--look-from x,y,z] "
+                 "[--look-at x,y,z] [--up x,y,z] [--vfov degrees]\n";
+    return 1;
+  }
 
   using params = render_params<128, 96>;
   static constexpr auto img = rt::render<params::width, params::height>();
 
+  if (opts->many_lights) {
+    return render_runtime<params>(*opts, rt::build_many_light_scene());
+  }
+  // the compile time image is the default view at 1 spp, anything else renders at runtime
+  if (opts->farm || opts->progressive || opts->wavefront || opts->packets || opts->view ||
+      opts->settings.samples_per_pixel != 1) {
+    return render_runtime<params>(*opts, rt::build_scene());
+  }
+
   // dump the bytes that make up the image...
   rt::dump_bytes(img);
 
@@ -20,4 +266,4 @@ auto main(int argc, char* argv[]) -> int {
   rt::save_ppm(img, "out.ppm");
 
   return 0;
-}
\ No newline at end of file
+}
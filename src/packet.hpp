@@ -0,0 +1,111 @@
+#ifndef PACKET_HPP
+#define PACKET_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "camera.hpp"
+#include "colour.hpp"
+#include "frustum.hpp"
+#include "image.hpp"
+#include "ray.hpp"
+#include "render.hpp"
+#include "scene.hpp"
+#include "util.hpp"
+
+// packet runtime renderer, primary rays through a square block of pixels are close to parallel and
+// hit the same objects, so the block is traced as one packet against each candidate object...
+// blocks never straddle a culling tile, the whole packet shares the tile's candidate list
+
+namespace rt::packet {
+
+// 4x4 blocks, 16 lanes
+inline constexpr std::size_t default_block_size = 4;
+
+template <std::size_t Width, std::size_t Height, std::size_t TileSize = default_tile_size,
+          std::size_t Block = default_block_size, boundable T, std::size_t N, std::size_t L>
+  requires(valid_image_dimensions<Width, Height> && (Width > 1) && (Height > 1) && (Block > 0) &&
+           (TileSize % Block == 0))
+[[nodiscard]] inline auto render(const scene<T, N, L>& world, const camera& cam,
+                                 const render_settings& settings) -> image<Width, Height> {
+  assert(settings.samples_per_pixel > 0 && "need at least one sample per pixel");
+  using grid = tile_grid<Width, Height, TileSize>;
+  using float_type = extracted_value_type_of_t<T>;
+  constexpr std::size_t lanes = Block * Block;
+
+  const camera_rays<Width, Height> camera_table{cam};
+  const auto tiles = cull_tiles<Width, Height, TileSize>(cam, world);
+  const auto objects = world.objects();
+  image<Width, Height> img{};
+
+  for (std::size_t row0 = 0; row0 < Height; row0 += Block) {
+    for (std::size_t col0 = 0; col0 < Width; col0 += Block) {
+      const auto candidates = tiles[grid::tile_of(col0, row0)].indices();
+
+      // lanes past the edge of the frame stay off, and reuse the edge pixel's table entries
+      lane_mask<lanes> active{};
+      std::array<std::size_t, lanes> cols{};
+      std::array<std::size_t, lanes> rows{};
+      for (std::size_t lane = 0; lane < lanes; ++lane) {
+        active[lane] = col0 + lane % Block < Width && row0 + lane / Block < Height;
+        cols[lane] = std::min(col0 + lane % Block, Width - 1);
+        rows[lane] = std::min(row0 + lane / Block, Height - 1);
+      }
+
+      std::array<colour_d, lanes> sums{};
+      for (std::size_t s = 0; s < settings.samples_per_pixel; ++s) {
+        const auto du = radical_inverse<double>(2, s);
+        const auto dv = radical_inverse<double>(3, s);
+        const auto offset = camera_table.offset(du, dv);
+        const auto rays = camera_table.get_rays(cols, rows, offset, active);
+        const auto hits = world.hit(rays, std::numeric_limits<float_type>::epsilon(),
+                                    std::numeric_limits<float_type>::infinity(), candidates);
+
+        // shading gets its rays whole from the table, not rebuilt from the packet's lanes...
+        // reading a vector back out of scalars that were only just stored stalls on every load
+        // and cost more than the shading itself
+        std::array<ray<float_type>, lanes> whole;
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+          whole[lane] = camera_table.get_ray(cols[lane], rows[lane], offset);
+        }
+
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+          if (!active[lane]) {
+            continue;
+          }
+          const ray<float_type>& r = whole[lane];
+          // only lit scenes ever look at light_u
+          const float_type light_u =
+              L > 0 ? static_cast<float_type>(light_sample_value(cols[lane], rows[lane], s))
+                    : float_type{0};
+          if (!hits.hit[lane]) {
+            sums[lane] = sums[lane] + shade(r, std::nullopt, world, light_u);
+            continue;
+          }
+          const std::optional hit{objects[hits.object[lane]].record(r, hits.t[lane])};
+          sums[lane] = sums[lane] + shade(r, hit, world, light_u);
+        }
+      }
+
+      for (std::size_t lane = 0; lane < lanes; ++lane) {
+        if (!active[lane]) {
+          continue;
+        }
+        const std::size_t col = col0 + lane % Block;
+        const std::size_t row = row0 + lane / Block;
+        const colour_d c = sums[lane] * (1.0 / static_cast<double>(settings.samples_per_pixel));
+        img.set_pixel(col, Height - row - 1, colour_to_pixel<double, std::uint8_t>(c));
+      }
+    }
+  }
+
+  return img;
+}
+
+} // namespace rt::packet
+
+#endif // PACKET_HPP
@@ -0,0 +1,136 @@
+#ifndef PROGRESSIVE_HPP
+#define PROGRESSIVE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "camera.hpp"
+#include "colour.hpp"
+#include "frustum.hpp"
+#include "image.hpp"
+#include "render.hpp"
+#include "scene.hpp"
+
+// progressive runtime renderer, trades a blocky first image for a very low time to first image...
+//
+// the first pass traces one ray per coarse block and fills the whole block with it, every pass
+// after that halves the block size and only traces the block corners the coarser passes skipped,
+// until each pixel has its own sample. after that each pass adds one more sample per pixel until
+// the frame converges. the current best image is handed out after every pass, and mid pass
+// whenever the flush interval runs out
+
+namespace rt::progressive {
+
+struct progressive_settings {
+  // the first pass traces one ray per block of this many pixels squared, must be a power of two
+  std::size_t coarse_size = 8;
+  // how long a running pass may go without flushing the current image
+  std::chrono::milliseconds flush_interval{100};
+};
+
+// what a flushed image represents
+struct progress {
+  std::size_t pass;
+  // side of the blocks still filled from a single ray, 1 once every pixel is traced
+  std::size_t block_size;
+  std::uint32_t samples_per_pixel;
+  // set on the final flush only
+  bool done;
+};
+
+template <std::size_t Width, std::size_t Height, std::size_t TileSize = default_tile_size,
+          boundable T, std::size_t N, std::size_t L, typename Flush>
+  requires(valid_image_dimensions<Width, Height> &&
+           std::invocable<Flush&, const image<Width, Height>&, const progress&>)
+[[nodiscard]] inline auto render(const scene<T, N, L>& world, const camera& cam,
+                                 const render_settings& settings,
+                                 const progressive_settings& prog, Flush flush)
+    -> image<Width, Height> {
+  assert(settings.samples_per_pixel > 0 && "need at least one sample per pixel");
+  if (!std::has_single_bit(prog.coarse_size)) {
+    throw std::invalid_argument("progressive coarse size must be a power of two");
+  }
+
+  using grid = tile_grid<Width, Height, TileSize>;
+  using clock = std::chrono::steady_clock;
+
+  const camera_rays<Width, Height> rays{cam};
+  const auto tiles = cull_tiles<Width, Height, TileSize>(cam, world);
+  std::vector<colour_d> sums(Width * Height);
+  std::vector<std::uint32_t> counts(Width * Height);
+  image<Width, Height> preview{};
+
+  progress state{0, prog.coarse_size, 1, false};
+  auto last_flush = clock::now();
+
+  // adds the next sample to (x, y), returns the pixel's new estimate
+  const auto trace = [&](const std::size_t x, const std::size_t y) -> pixel_u8 {
+    const std::size_t row = Height - y - 1;
+    const std::size_t i = y * Width + x;
+    sums[i] = sums[i] + render_sample(rays, world, tiles[grid::tile_of(x, row)].indices(), x, row,
+                                      counts[i]);
+    counts[i] += 1;
+    return colour_to_pixel<double, std::uint8_t>(sums[i] * (1.0 / static_cast<double>(counts[i])));
+  };
+
+  const auto maybe_flush = [&] {
+    if (clock::now() - last_flush >= prog.flush_interval) {
+      flush(preview, state);
+      last_flush = clock::now();
+    }
+  };
+
+  const auto end_pass = [&](const bool done) {
+    state.done = done;
+    flush(preview, state);
+    last_flush = clock::now();
+    state.pass += 1;
+  };
+
+  // resolution passes...
+  for (std::size_t step = prog.coarse_size; step > 0; step /= 2) {
+    state.block_size = step;
+    for (std::size_t y = 0; y < Height; y += step) {
+      for (std::size_t x = 0; x < Width; x += step) {
+        const bool traced = step != prog.coarse_size && x % (2 * step) == 0 && y % (2 * step) == 0;
+        if (traced) {
+          continue;
+        }
+
+        // fill the block, finer passes overwrite their part of it later
+        const pixel_u8 px = trace(x, y);
+        for (std::size_t by = y; by < std::min(y + step, Height); ++by) {
+          for (std::size_t bx = x; bx < std::min(x + step, Width); ++bx) {
+            preview.set_pixel(bx, by, px);
+          }
+        }
+      }
+      maybe_flush();
+    }
+    end_pass(step == 1 && settings.samples_per_pixel <= 1);
+  }
+
+  // then sample passes
+  for (std::uint32_t s = 2; s <= settings.samples_per_pixel; ++s) {
+    state.samples_per_pixel = s;
+    for (std::size_t y = 0; y < Height; ++y) {
+      for (std::size_t x = 0; x < Width; ++x) {
+        preview.set_pixel(x, y, trace(x, y));
+      }
+      maybe_flush();
+    }
+    end_pass(s == settings.samples_per_pixel);
+  }
+
+  return preview;
+}
+
+} // namespace rt::progressive
+
+#endif // PROGRESSIVE_HPP
@@ -1,7 +1,10 @@
 #ifndef RAY_HPP
 #define RAY_HPP
 
+#include <array>
+#include <cstdint>
 #include <optional>
+#include <span>
 
 #include "point3.hpp"
 #include "vec3.hpp"
@@ -62,6 +65,58 @@ template <ray_value_type_compatible T> struct hit_record {
 
 using hit_record_d = hit_record<double>;
 
+// per lane flags for packets, lanes that are off are skipped by every packet operation
+template <std::size_t N> using lane_mask = std::array<bool, N>;
+
+// any number of rays in structure of arrays form, one span per component... what the per object
+// lane kernels take, s.t. packets and wavefront batches share them
+template <ray_value_type_compatible T> struct ray_soa {
+  [[nodiscard]] constexpr auto size() const noexcept -> std::size_t {
+    return ox.size();
+  }
+
+  std::span<const T> ox;
+  std::span<const T> oy;
+  std::span<const T> oz;
+  std::span<const T> dx;
+  std::span<const T> dy;
+  std::span<const T> dz;
+};
+
+// N rays in structure of arrays form s.t. a packet operation runs the same maths down every lane
+template <ray_value_type_compatible T, std::size_t N>
+  requires(N > 0)
+struct ray_packet {
+  using value_type = T;
+  static constexpr std::size_t lanes = N;
+
+  [[nodiscard]] constexpr auto at(const std::size_t i) const noexcept -> ray<T> {
+    return {{ox[i], oy[i], oz[i]}, {dx[i], dy[i], dz[i]}};
+  }
+
+  // every lane, active or not
+  [[nodiscard]] constexpr auto soa() const noexcept -> ray_soa<T> {
+    return {ox, oy, oz, dx, dy, dz};
+  }
+
+  std::array<T, N> ox{};
+  std::array<T, N> oy{};
+  std::array<T, N> oz{};
+  std::array<T, N> dx{};
+  std::array<T, N> dy{};
+  std::array<T, N> dz{};
+  lane_mask<N> active{};
+};
+
+// closest hit for each lane of a packet, object indexes the scene for lanes where hit is set
+template <ray_value_type_compatible T, std::size_t N>
+  requires(N > 0)
+struct packet_hit {
+  std::array<T, N> t{};
+  std::array<std::size_t, N> object{};
+  lane_mask<N> hit{};
+};
+
 } // namespace rt
 
 #endif // RAY_HPP
\ No newline at end of file
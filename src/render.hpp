@@ -2,15 +2,19 @@
 #define RENDER_HPP
 
 #include <array>
+#include <cassert>
 #include <cmath>
 #include <concepts>
 #include <cstdint>
 #include <limits>
+#include <optional>
 #include <print>
 #include <ranges>
+#include <span>
 
 #include "camera.hpp"
 #include "colour.hpp"
+#include "frustum.hpp"
 #include "image.hpp"
 #include "ray.hpp"
 #include "scene.hpp"
@@ -19,7 +23,7 @@
 
 namespace rt {
 
-template <std::size_t N> using sphere_scene = scene<sphere_d, N>;
+template <std::size_t N, std::size_t L = 0> using sphere_scene = scene<sphere_d, N, L>;
 
 [[nodiscard]] constexpr auto build_scene() noexcept -> sphere_scene<3> {
   sphere_scene<3> world{};
@@ -29,6 +33,65 @@ template <std::size_t N> using sphere_scene = scene<sphere_d, N>;
   return world;
 }
 
+inline constexpr std::size_t many_light_count = 64;
+
+// the same spheres under a grid of point lights, a few bright ones among many dim ones... what
+// power weighted light selection is for
+[[nodiscard]] constexpr auto build_many_light_scene() noexcept
+    -> sphere_scene<3, many_light_count> {
+  sphere_scene<3, many_light_count> world{};
+  const auto spheres = build_scene();
+  for (const auto& obj : spheres.objects()) {
+    world.add(obj);
+  }
+
+  constexpr std::size_t side = 8;
+  for (std::size_t i = 0; i < many_light_count; ++i) {
+    const auto x = -3.0 + 6.0 * static_cast<double>(i % side) / static_cast<double>(side - 1);
+    const auto z = -4.0 + 6.0 * static_cast<double>(i / side) / static_cast<double>(side - 1);
+    const double strength = i % 16 == 5 ? 6.0 : 0.05;
+    const colour_d tint{0.6 + 0.4 * static_cast<double>(i % 3) / 2.0, 0.8,
+                        1.0 - 0.4 * static_cast<double>(i % 5) / 4.0};
+    world.add_light(point_light_d{{x, 2.0, z}, strength * tint});
+  }
+  world.build_light_table();
+  return world;
+}
+
+// the many light scene's table draws every light in proportion to its power, up to rounding
+[[nodiscard]] consteval auto many_light_table_follows_power() noexcept -> bool {
+  const auto world = build_many_light_scene();
+  const auto lights = world.lights();
+
+  double total_power{};
+  for (const auto& light : lights) {
+    total_power += light.power();
+  }
+
+  constexpr double tolerance = 1e-12;
+  double total_pmf{};
+  for (std::size_t i = 0; i < lights.size(); ++i) {
+    const double expected = lights[i].power() / total_power;
+    const double error = world.light_pmf(i) - expected;
+    if (error > tolerance * expected || -error > tolerance * expected) {
+      return false;
+    }
+    total_pmf += world.light_pmf(i);
+  }
+  return total_pmf - 1.0 < tolerance && 1.0 - total_pmf < tolerance;
+}
+
+static_assert(many_light_table_follows_power());
+
+// a scene whose lights all give off nothing has none to draw, rather than a table of nan pmfs
+static_assert([] {
+  sphere_scene<1, 2> world{};
+  world.add_light(point_light_d{{0.0, 1.0, 0.0}, colour_d{}});
+  world.add_light(point_light_d{{0.0, 2.0, 0.0}, colour_d{}});
+  world.build_light_table();
+  return !world.has_lights();
+}());
+
 // guess what this function does...
 template <colour_value_type_compatible C, pixel_value_type_compatible P>
 [[nodiscard]] constexpr auto colour_to_pixel(const colour<C>& c) noexcept -> pixel<P> {
@@ -55,45 +118,222 @@ template <colour_value_type_compatible C, pixel_value_type_compatible P>
   return {to_channel(c.r()), to_channel(c.g()), to_channel(c.b())};
 }
 
+// colour for a ray given whatever it hit, if anything...
+template <ray_value_type_compatible T>
+[[nodiscard]] constexpr auto shade(const ray<T>& r,
+                                   const std::optional<hit_record<T>>& hit) noexcept -> colour<T>
+  requires(std::floating_point<T>)
+{
+  if (hit) {
+    // show normals...
+    const auto& n = hit->normal;
+    return colour<T>{T{0.5} * (n.x() + T{1}), T{0.5} * (n.y() + T{1}), T{0.5} * (n.z() + T{1})};
+  }
+
+  // background gradient
+  const auto unit_dir = unit_vector(r.direction());
+  const T t = T{0.5} * (unit_dir.y() + T{1});
+  const colour<T> white{T{1}, T{1}, T{1}};
+  const colour<T> blue{T{0.5}, T{0.7}, T{1}};
+  return (T{1} - t) * white + t * blue;
+}
+
+// shadow rays start this far off the surface s.t. they don't hit it again
+inline constexpr double shadow_epsilon = 1e-6;
+
+// one light drawn out of the scene's light table for a hit point... the shadow ray towards it, how
+// far away it is and the light arriving if nothing is in the way, divided by the probability of
+// drawing it. unbiased whatever the table's weights, they only move the noise
+template <std::floating_point T> struct light_path {
+  ray<T> shadow;
+  T distance;
+  colour<T> radiance;
+};
+
+// nullopt when the light is behind the surface
+template <boundable T, std::size_t N, std::size_t L>
+[[nodiscard]] constexpr auto sample_direct(const scene<T, N, L>& world,
+                                           const hit_record<extracted_value_type_of_t<T>>& rec,
+                                           const extracted_value_type_of_t<T> light_u) noexcept
+    -> std::optional<light_path<extracted_value_type_of_t<T>>> {
+  using float_type = extracted_value_type_of_t<T>;
+
+  const auto [light, pmf] = world.sample_light(light_u);
+  const auto to_light = light.position() - rec.p;
+  const float_type dist_squared = to_light.length_squared();
+  const float_type dist = to_light.length();
+  const auto l = to_light / dist;
+  const float_type cos_theta = dot(rec.normal, l);
+  if (cos_theta <= float_type{0}) {
+    return std::nullopt;
+  }
+  return light_path<float_type>{
+      {rec.p, l}, dist, (cos_theta / (dist_squared * pmf)) * light.intensity()};
+}
+
+// light arriving at a hit point from one sampled light, the shadow ray is traced right away
+template <boundable T, std::size_t N, std::size_t L>
+[[nodiscard]] constexpr auto direct_light(const scene<T, N, L>& world,
+                                          const hit_record<extracted_value_type_of_t<T>>& rec,
+                                          const extracted_value_type_of_t<T> light_u) noexcept
+    -> colour<extracted_value_type_of_t<T>> {
+  using float_type = extracted_value_type_of_t<T>;
+
+  const auto path = sample_direct(world, rec, light_u);
+  if (!path || world.hit(path->shadow, static_cast<float_type>(shadow_epsilon), path->distance)) {
+    return colour<float_type>{};
+  }
+  return path->radiance;
+}
+
+// as above, but surfaces are lit by the scene's lights if it has any... the normal colour becomes
+// the surface albedo. light_u is uniform in [0, 1) and picks the light
+template <scene_value_type_compatible Scene>
+[[nodiscard]] constexpr auto
+shade(const ray<extracted_value_type_of_t<Scene>>& r,
+      const std::optional<hit_record<extracted_value_type_of_t<Scene>>>& hit, const Scene& world,
+      const extracted_value_type_of_t<Scene> light_u) noexcept
+    -> colour<extracted_value_type_of_t<Scene>>
+  requires(std::floating_point<extracted_value_type_of_t<Scene>>)
+{
+  if constexpr (Scene::light_capacity > 0) {
+    if (hit && world.has_lights()) {
+      return shade(r, hit) * direct_light(world, *hit, light_u);
+    }
+  }
+  return shade(r, hit);
+}
+
 template <scene_value_type_compatible Scene>
 [[nodiscard]] constexpr auto ray_colour(const ray<extracted_value_type_of_t<Scene>>& r,
-                                        const Scene& world) noexcept
+                                        const Scene& world,
+                                        const extracted_value_type_of_t<Scene> light_u) noexcept
     -> colour<extracted_value_type_of_t<Scene>>
   requires(std::floating_point<extracted_value_type_of_t<Scene>>)
 {
   using float_type = extracted_value_type_of_t<Scene>;
 
-  const auto hit = world.hit(r, std::numeric_limits<float_type>::epsilon(),
-                             std::numeric_limits<float_type>::infinity());
-  if (hit) {
-    // show normals...
-    const auto& n = hit->normal;
-    return colour<float_type>{float_type{0.5} * (n.x() + float_type{1}),
-                              float_type{0.5} * (n.y() + float_type{1}),
-                              float_type{0.5} * (n.z() + float_type{1})};
+  return shade(r,
+               world.hit(r, std::numeric_limits<float_type>::epsilon(),
+                         std::numeric_limits<float_type>::infinity()),
+               world, light_u);
+}
+
+// primary rays only, candidates come from the tile the ray passes through (see frustum.hpp)
+template <scene_value_type_compatible Scene>
+[[nodiscard]] constexpr auto ray_colour(const ray<extracted_value_type_of_t<Scene>>& r,
+                                        const Scene& world,
+                                        const std::span<const std::size_t> candidates,
+                                        const extracted_value_type_of_t<Scene> light_u) noexcept
+    -> colour<extracted_value_type_of_t<Scene>>
+  requires(std::floating_point<extracted_value_type_of_t<Scene>>)
+{
+  using float_type = extracted_value_type_of_t<Scene>;
+
+  return shade(r,
+               world.hit(r, std::numeric_limits<float_type>::epsilon(),
+                         std::numeric_limits<float_type>::infinity(), candidates),
+               world, light_u);
+}
+
+// primary rays are culled per tile of this many pixels squared...
+inline constexpr std::size_t default_tile_size = 8;
+
+// knobs for everything downstream of the scene and camera, kept trivially copyable s.t. it can be
+// shipped to other processes as is
+struct render_settings {
+  std::uint32_t samples_per_pixel = 1;
+};
+
+// uniform used to pick a light for a sample, a base 5 radical inverse (independent of the halton
+// bases used for the pixel offsets) rotated by a per pixel hash s.t. neighbouring pixels don't
+// pick the same lights in the same order
+[[nodiscard]] constexpr auto light_sample_value(const std::size_t col, const std::size_t row,
+                                                const std::size_t sample) noexcept -> double {
+  // splitmix64 finaliser
+  std::uint64_t h = (static_cast<std::uint64_t>(row) << 32U) ^ static_cast<std::uint64_t>(col);
+  h += 0x9e3779b97f4a7c15U;
+  h = (h ^ (h >> 30U)) * 0xbf58476d1ce4e5b9U;
+  h = (h ^ (h >> 27U)) * 0x94d049bb133111ebU;
+  h ^= h >> 31U;
+  const double rotation = static_cast<double>(h >> 11U) * 0x1.0p-53;
+
+  const double u = radical_inverse<double>(5, sample) + rotation;
+  return u < 1.0 ? u : u - 1.0;
+}
+
+// one sample through a pixel, col and row are in camera space (row 0 at the bottom)... successive
+// sample indices walk a halton sequence over the pixel, sample 0 sits on its corner
+template <std::size_t Width, std::size_t Height, scene_value_type_compatible Scene>
+  requires(valid_image_dimensions<Width, Height> && (Width > 1) && (Height > 1))
+[[nodiscard]] constexpr auto render_sample(const camera_rays<Width, Height>& rays,
+                                           const Scene& world,
+                                           const std::span<const std::size_t> candidates,
+                                           const std::size_t col, const std::size_t row,
+                                           const std::size_t sample) noexcept -> colour_d {
+  const auto du = radical_inverse<double>(2, sample);
+  const auto dv = radical_inverse<double>(3, sample);
+  const ray_d r = rays.get_ray(col, row, rays.offset(du, dv));
+  return ray_colour(r, world, candidates, light_sample_value(col, row, sample));
+}
+
+// average of the samples through one pixel
+template <std::size_t Width, std::size_t Height, scene_value_type_compatible Scene>
+  requires(valid_image_dimensions<Width, Height> && (Width > 1) && (Height > 1))
+[[nodiscard]] constexpr auto render_pixel(const camera_rays<Width, Height>& rays,
+                                          const Scene& world,
+                                          const std::span<const std::size_t> candidates,
+                                          const std::size_t col, const std::size_t row,
+                                          const render_settings& settings) noexcept -> colour_d {
+  assert(settings.samples_per_pixel > 0 && "need at least one sample per pixel");
+  colour_d sum{};
+  for (std::size_t s = 0; s < settings.samples_per_pixel; ++s) {
+    sum = sum + render_sample(rays, world, candidates, col, row, s);
   }
+  return sum * (1.0 / static_cast<double>(settings.samples_per_pixel));
+}
 
-  // background gradient
-  const auto unit_dir = unit_vector(r.direction());
-  const float_type t = float_type{0.5} * (unit_dir.y() + float_type{1});
-  const colour<float_type> white{float_type{1}, float_type{1}, float_type{1}};
-  const colour<float_type> blue{float_type{0.5}, float_type{0.7}, float_type{1}};
-  return (float_type{1} - t) * white + t * blue;
+// renders one rect of the frame into out, row major with the rect's top row first...
+template <std::size_t Width, std::size_t Height, std::size_t TileSize, boundable T, std::size_t N,
+          std::size_t L>
+  requires valid_image_dimensions<Width, Height>
+constexpr void render_rect(const camera_rays<Width, Height>& rays, const scene<T, N, L>& world,
+                           const tile_candidates<Width, Height, TileSize, N>& tiles,
+                           const image_rect rect, const render_settings& settings,
+                           const std::span<pixel_u8> out) noexcept {
+  using grid = tile_grid<Width, Height, TileSize>;
+  assert(rect.x1 <= Width && rect.y1 <= Height && "rect outside of the image");
+  assert(out.size() >= rect.size() && "output too small for rect");
+
+  std::size_t i = 0;
+  for (std::size_t y = rect.y0; y < rect.y1; ++y) {
+    const std::size_t row = Height - y - 1;
+    for (std::size_t col = rect.x0; col < rect.x1; ++col) {
+      const auto& candidates = tiles[grid::tile_of(col, row)];
+      const colour_d c = render_pixel(rays, world, candidates.indices(), col, row, settings);
+      out[i] = colour_to_pixel<double, std::uint8_t>(c);
+      i += 1;
+    }
+  }
 }
 
-template <std::size_t Width, std::size_t Height>
+template <std::size_t Width, std::size_t Height, std::size_t TileSize = default_tile_size>
   requires valid_image_dimensions<Width, Height>
-[[nodiscard]] consteval auto render() noexcept -> image<Width, Height> {
+[[nodiscard]] consteval auto render(const camera_settings& view = {}) noexcept
+    -> image<Width, Height> {
+  using grid = tile_grid<Width, Height, TileSize>;
+
   const auto world = build_scene();
-  const camera cam{};
+  const auto cam = camera_for<Width, Height>(view);
+  const camera_rays<Width, Height> rays{cam};
+  const auto tiles = cull_tiles<Width, Height, TileSize>(cam, world);
+  const render_settings settings{};
   image<Width, Height> img{};
 
   for (const auto [row, col] : std::views::cartesian_product(
            std::views::iota(std::size_t{0}, Height), std::views::iota(std::size_t{0}, Width))) {
-    const auto u = static_cast<double>(col) / static_cast<double>(Width - 1);
-    const auto v = static_cast<double>(row) / static_cast<double>(Height - 1);
-    const ray_d r = cam.get_ray(u, v);
-    const colour_d pixel_colour = ray_colour(r, world);
+    const colour_d pixel_colour =
+        render_pixel(rays, world, tiles[grid::tile_of(col, row)].indices(), col, row, settings);
     img.set_pixel(col, Height - row - 1, colour_to_pixel<double, std::uint8_t>(pixel_colour));
   }
 
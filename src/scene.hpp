@@ -3,10 +3,14 @@
 
 #include <array>
 #include <cassert>
+#include <concepts>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <span>
 
+#include "alias_table.hpp"
+#include "light.hpp"
 #include "ray.hpp"
 #include "sphere.hpp"
 
@@ -27,19 +31,34 @@ concept scene_value_type_compatible =
       } -> std::same_as<std::optional<hit_record<extracted_value_type_of_t<T>>>>;
     };
 
-template <scene_value_type_compatible T, std::size_t N> class scene;
+// how the light table weighs each light, uniform is mostly there to compare against
+enum class light_selection : std::uint8_t {
+  power,
+  uniform,
+};
+
+// N objects, L lights
+template <scene_value_type_compatible T, std::size_t N, std::size_t L = 0> class scene;
 
 // scene extracts nested value_type
-template <scene_value_type_compatible T, std::size_t N>
-struct extracted_value_type_of<scene<T, N>> {
+template <scene_value_type_compatible T, std::size_t N, std::size_t L>
+struct extracted_value_type_of<scene<T, N, L>> {
   using type = extracted_value_type_of_t<T>; // recurse
 };
 
-template <scene_value_type_compatible T, std::size_t N> class scene {
+template <scene_value_type_compatible T, std::size_t N, std::size_t L> class scene {
 public:
   using value_type = T;
   using size_type = std::size_t;
   using float_type = extracted_value_type_of_t<T>;
+  using light_type = point_light<float_type>;
+
+  struct light_sample {
+    light_type light;
+    float_type pmf;
+  };
+
+  static constexpr size_type light_capacity = L;
 
   [[nodiscard]] constexpr scene() noexcept = default;
 
@@ -49,6 +68,51 @@ public:
     m_count += 1;
   }
 
+  // lights only become visible to sample_light once the table is (re)built
+  constexpr void add_light(const light_type& light) noexcept {
+    assert(m_light_count < L && "scene light capacity exceeded");
+    m_lights[m_light_count] = light;
+    m_light_count += 1;
+  }
+
+  // call once all lights are in, at compile time for constexpr scenes or at load time otherwise...
+  // no lights, or none giving off anything, leaves the table empty s.t. has_lights() is false
+  constexpr void
+  build_light_table(const light_selection selection = light_selection::power) noexcept {
+    std::array<float_type, L> weights{};
+    float_type total{};
+    for (size_type i = 0; i < m_light_count; ++i) {
+      weights[i] = selection == light_selection::power ? m_lights[i].power() : float_type{1};
+      total += weights[i];
+    }
+    if (!(total > float_type{0})) {
+      m_light_table = alias_table<float_type, L>{};
+      return;
+    }
+    m_light_table =
+        alias_table<float_type, L>{std::span<const float_type>{weights.data(), m_light_count}};
+  }
+
+  // O(1) regardless of the light count, u is uniform in [0, 1)
+  [[nodiscard]] constexpr auto sample_light(const float_type u) const noexcept -> light_sample {
+    assert(!m_light_table.empty() && "no light table, call build_light_table");
+    const auto [index, pmf] = m_light_table.sample(u);
+    return {m_lights[index], pmf};
+  }
+
+  // probability that sample_light draws light i
+  [[nodiscard]] constexpr auto light_pmf(const size_type i) const noexcept -> float_type {
+    return m_light_table.pmf(i);
+  }
+
+  [[nodiscard]] constexpr auto has_lights() const noexcept -> bool {
+    return !m_light_table.empty();
+  }
+
+  [[nodiscard]] constexpr auto lights() const noexcept -> std::span<const light_type> {
+    return std::span<const light_type>{m_lights.data(), m_light_count};
+  }
+
   [[nodiscard]] constexpr auto hit(const ray<float_type>& r, const float_type t_min,
                                    const float_type t_max) const noexcept
       -> std::optional<hit_record<float_type>> {
@@ -65,9 +129,64 @@ public:
     return closest_hit;
   }
 
+  // same as above, but only tests the objects at the given indices (see frustum.hpp)...
+  [[nodiscard]] constexpr auto hit(const ray<float_type>& r, const float_type t_min,
+                                   const float_type t_max,
+                                   const std::span<const size_type> candidates) const noexcept
+      -> std::optional<hit_record<float_type>> {
+    std::optional<hit_record<float_type>> closest_hit;
+    float_type closest_so_far = t_max;
+
+    for (const size_type i : candidates) {
+      assert(i < m_count && "candidate index out of range");
+      if (const auto hit_opt = m_objects[i].hit(r, t_min, closest_so_far)) {
+        closest_hit = hit_opt;
+        closest_so_far = hit_opt->t;
+      }
+    }
+
+    return closest_hit;
+  }
+
+  // packet version of the above, for objects with a lane kernel... lanes that are off get an
+  // empty range s.t. no object takes them
+  template <std::size_t Lanes>
+  [[nodiscard]] constexpr auto hit(const ray_packet<float_type, Lanes>& rays,
+                                   const float_type t_min, const float_type t_max,
+                                   const std::span<const size_type> candidates) const noexcept
+      -> packet_hit<float_type, Lanes>
+    requires requires(const value_type& obj, std::span<float_type> ts, std::span<bool> mask) {
+      obj.hit(rays.soa(), t_min, ts, mask);
+    }
+  {
+    packet_hit<float_type, Lanes> hits{};
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+      hits.t[lane] = rays.active[lane] ? t_max : -std::numeric_limits<float_type>::infinity();
+    }
+
+    lane_mask<Lanes> closer{};
+    for (const size_type i : candidates) {
+      assert(i < m_count && "candidate index out of range");
+      m_objects[i].hit(rays.soa(), t_min, hits.t, closer);
+      for (std::size_t lane = 0; lane < Lanes; ++lane) {
+        hits.object[lane] = closer[lane] ? i : hits.object[lane];
+        hits.hit[lane] = hits.hit[lane] || closer[lane];
+      }
+    }
+
+    return hits;
+  }
+
+  [[nodiscard]] constexpr auto objects() const noexcept -> std::span<const value_type> {
+    return std::span<const value_type>{m_objects.data(), m_count};
+  }
+
 private:
   std::array<value_type, N> m_objects{};
   std::size_t m_count{};
+  std::array<light_type, L> m_lights{};
+  std::size_t m_light_count{};
+  alias_table<float_type, L> m_light_table{};
 };
 
 } // namespace rt
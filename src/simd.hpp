@@ -0,0 +1,72 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <array>
+#include <concepts>
+#include <cstring>
+
+namespace rt::simd {
+
+// element types we have registers for...
+template <typename T>
+concept element = std::same_as<T, float> || std::same_as<T, double>;
+
+// 128 bit registers only, they are baseline on x86-64 and aarch64... wider vector types change the
+// calling convention unless the whole build targets them
+inline constexpr std::size_t register_width = 16;
+
+// vector_size can't be applied to a dependent type, so one specialisation per element
+template <element T> struct traits;
+
+template <> struct traits<float> {
+  using register_type = float __attribute__((vector_size(register_width)));
+  static constexpr std::size_t register_bytes = register_width;
+  static constexpr std::size_t lanes_per_register = register_bytes / sizeof(float);
+};
+
+template <> struct traits<double> {
+  using register_type = double __attribute__((vector_size(register_width)));
+  static constexpr std::size_t register_bytes = register_width;
+  static constexpr std::size_t lanes_per_register = register_bytes / sizeof(double);
+};
+
+static_assert(sizeof(traits<float>::register_type) == register_width);
+static_assert(sizeof(traits<double>::register_type) == register_width);
+
+// lane-wise op over arrays spanning whole registers, runtime only as vector types can't be used in
+// constant evaluation... op sees one register of each argument at a time
+template <element T, std::size_t Lanes, typename Op>
+  requires(Lanes % traits<T>::lanes_per_register == 0)
+[[nodiscard]] inline auto map(const std::array<T, Lanes>& a, const std::array<T, Lanes>& b,
+                              Op op) noexcept -> std::array<T, Lanes> {
+  using reg = typename traits<T>::register_type;
+  std::array<T, Lanes> out;
+  for (std::size_t i = 0; i < Lanes; i += traits<T>::lanes_per_register) {
+    reg x;
+    reg y;
+    std::memcpy(&x, a.data() + i, sizeof(reg));
+    std::memcpy(&y, b.data() + i, sizeof(reg));
+    const reg r = op(x, y);
+    std::memcpy(out.data() + i, &r, sizeof(reg));
+  }
+  return out;
+}
+
+template <element T, std::size_t Lanes, typename Op>
+  requires(Lanes % traits<T>::lanes_per_register == 0)
+[[nodiscard]] inline auto map(const std::array<T, Lanes>& a, Op op) noexcept
+    -> std::array<T, Lanes> {
+  using reg = typename traits<T>::register_type;
+  std::array<T, Lanes> out;
+  for (std::size_t i = 0; i < Lanes; i += traits<T>::lanes_per_register) {
+    reg x;
+    std::memcpy(&x, a.data() + i, sizeof(reg));
+    const reg r = op(x);
+    std::memcpy(out.data() + i, &r, sizeof(reg));
+  }
+  return out;
+}
+
+} // namespace rt::simd
+
+#endif // SIMD_HPP
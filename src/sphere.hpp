@@ -1,10 +1,15 @@
 #ifndef SPHERE_HPP
 #define SPHERE_HPP
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <limits>
 #include <optional>
+#include <span>
 
+#include "bounds.hpp"
 #include "point3.hpp"
 #include "ray.hpp"
 #include "util.hpp"
@@ -46,7 +51,12 @@ public:
       return std::nullopt;
     }
 
-    const value_type sqrtd = sqrt_constexpr(discriminant);
+    value_type sqrtd{};
+    if consteval {
+      sqrtd = sqrt_constexpr(discriminant);
+    } else {
+      sqrtd = std::sqrt(discriminant);
+    }
 
     // nearest root in range
     value_type root = (-half_b - sqrtd) / a;
@@ -57,14 +67,95 @@ public:
       }
     }
 
+    return record(r, root);
+  }
+
+  // lane kernel, every ray against this sphere... lanes with a root in [t_min, t_max[i]] get
+  // t_max[i] lowered to it and hits[i] set, the rest get hits[i] cleared. an empty range, e.g.
+  // t_max[i] below t_min, keeps a lane out. packets, wavefront intersect and occlude all come
+  // through here
+  constexpr void hit(const ray_soa<value_type> rays, const value_type t_min,
+                     const std::span<value_type> t_max, const std::span<bool> hits) const noexcept {
+    assert(t_max.size() == rays.size() && hits.size() == rays.size() && "lane count mismatch");
+    const value_type cx = m_center.x();
+    const value_type cy = m_center.y();
+    const value_type cz = m_center.z();
+    const value_type rr = m_radius * m_radius;
+
+    // plain pointers, loads through the spans' own members get redone after every store
+    const value_type* const ox = rays.ox.data();
+    const value_type* const oy = rays.oy.data();
+    const value_type* const oz = rays.oz.data();
+    const value_type* const dx = rays.dx.data();
+    const value_type* const dy = rays.dy.data();
+    const value_type* const dz = rays.dz.data();
+    value_type* const ts = t_max.data();
+    bool* const taken = hits.data();
+
+    // roots first, a chunk at a time, in a loop that only touches floating point lanes s.t. it
+    // vectorises... a bool store in the same loop stops it. lanes without a root in range get
+    // infinity
+    constexpr std::size_t chunk = 64;
+    constexpr value_type none = std::numeric_limits<value_type>::infinity();
+    std::array<value_type, chunk> roots;
+    for (std::size_t first = 0; first < rays.size(); first += chunk) {
+      const std::size_t count = std::min(chunk, rays.size() - first);
+
+      for (std::size_t j = 0; j < count; ++j) {
+        const std::size_t i = first + j;
+        const value_type ocx = ox[i] - cx;
+        const value_type ocy = oy[i] - cy;
+        const value_type ocz = oz[i] - cz;
+        const value_type a = dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i];
+        const value_type half_b = ocx * dx[i] + ocy * dy[i] + ocz * dz[i];
+        const value_type c = ocx * ocx + ocy * ocy + ocz * ocz - rr;
+        const value_type discriminant = half_b * half_b - a * c;
+
+        // a negative discriminant makes both roots nan, and nan fails every comparison below
+        value_type sqrtd{};
+        if consteval {
+          sqrtd = sqrt_constexpr(discriminant);
+        } else {
+          sqrtd = std::sqrt(discriminant);
+        }
+        const value_type near = (-half_b - sqrtd) / a;
+        const value_type far = (-half_b + sqrtd) / a;
+        // non short circuiting & keeps the loop free of branches
+        const bool near_ok = (near >= t_min) & (near <= ts[i]);
+        const bool far_ok = (far >= t_min) & (far <= ts[i]);
+        const value_type root = far_ok ? far : none;
+        roots[j] = near_ok ? near : root;
+      }
+
+      for (std::size_t j = 0; j < count; ++j) {
+        const bool take = roots[j] != none;
+        ts[first + j] = take ? roots[j] : ts[first + j];
+        taken[first + j] = take;
+      }
+    }
+  }
+
+  // fills in the record for a ray known to hit at t
+  [[nodiscard]] constexpr auto record(const ray<value_type>& r, const value_type t) const noexcept
+      -> hit_record<value_type> {
     hit_record<value_type> rec;
-    rec.t = root;
-    rec.p = r.at(root);
+    rec.t = t;
+    rec.p = r.at(t);
     rec.set_face_normal(r, (rec.p - m_center) / m_radius);
-
     return rec;
   }
 
+  [[nodiscard]] constexpr auto center() const noexcept -> point3<value_type> {
+    return m_center;
+  }
+  [[nodiscard]] constexpr auto radius() const noexcept -> value_type {
+    return m_radius;
+  }
+
+  [[nodiscard]] constexpr auto bounds() const noexcept -> bounding_sphere<value_type> {
+    return {m_center, m_radius};
+  }
+
 private:
   point3<value_type> m_center;
   value_type m_radius;
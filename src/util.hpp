@@ -56,6 +56,46 @@ template <sqrt_compatible T>
   return result;
 }
 
+template <typename T>
+concept tan_compatible = std::floating_point<T>;
+
+// constexpr tan from taylor series of sin and cos, |x| < pi / 2... plenty accurate for camera
+// setup, and the same in constant evaluation and at runtime s.t. both give the same rays
+template <tan_compatible T> [[nodiscard]] constexpr auto tan_constexpr(const T x) noexcept -> T {
+  const T x2 = x * x;
+  T term = x;
+  T sin = x;
+  T cos_term = T{1};
+  T cos = T{1};
+  for (std::size_t n = 1; n <= 12; ++n) {
+    term *= -x2 / static_cast<T>((2 * n) * (2 * n + 1));
+    cos_term *= -x2 / static_cast<T>((2 * n - 1) * (2 * n));
+    sin += term;
+    cos += cos_term;
+  }
+  return sin / cos;
+}
+
+[[nodiscard]] constexpr auto degrees_to_radians(const double degrees) noexcept -> double {
+  return degrees * std::numbers::pi / 180.0;
+}
+
+// van der corput radical inverse, pairing bases 2 and 3 gives a halton sequence in [0, 1)^2 whose
+// first point is the origin...
+template <std::floating_point T>
+[[nodiscard]] constexpr auto radical_inverse(const std::size_t base, std::size_t index) noexcept
+    -> T {
+  const T inv_base = T{1} / static_cast<T>(base);
+  T scale = inv_base;
+  T result{};
+  while (index > 0) {
+    result += static_cast<T>(index % base) * scale;
+    index /= base;
+    scale *= inv_base;
+  }
+  return result;
+}
+
 } // namespace rt
 
 #endif // UTIL_HPP`
\ No newline at end of file
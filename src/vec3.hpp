@@ -3,7 +3,9 @@
 
 #include <array>
 #include <cmath>
+#include <functional>
 
+#include "simd.hpp"
 #include "util.hpp"
 
 namespace rt {
@@ -15,10 +17,27 @@ concept vec3_value_type_compatible = requires {
   requires std::is_trivially_default_constructible_v<T>;
 };
 
+// storage policy, float and double get a padding lane s.t. a vec3 fills whole simd registers...
+// nothing ever reads the padding lane, it only has to exist
+template <vec3_value_type_compatible T> struct vec3_storage {
+  static constexpr std::size_t lanes = 3;
+  static constexpr std::size_t alignment = alignof(T);
+  static constexpr bool vectorised = false;
+};
+
+template <vec3_value_type_compatible T>
+  requires simd::element<T>
+struct vec3_storage<T> {
+  static constexpr std::size_t lanes = 4;
+  static constexpr std::size_t alignment = simd::traits<T>::register_bytes;
+  static constexpr bool vectorised = true;
+};
+
 template <vec3_value_type_compatible T> class vec3 {
 public:
   using value_type = T;
   using size_type = std::size_t;
+  using storage = vec3_storage<T>;
 
   [[nodiscard]] constexpr vec3() noexcept = default;
   [[nodiscard]] constexpr vec3(const value_type x, const value_type y, const value_type z) noexcept
@@ -35,12 +54,19 @@ public:
   }
 
   [[nodiscard]] constexpr auto length_squared() const noexcept -> value_type {
-    return m_elems[0] * m_elems[0] + m_elems[1] * m_elems[1] + m_elems[2] * m_elems[2];
+    // same summation order as the scalar path, s.t. both agree to the bit
+    const vec3<value_type> sq = *this * *this;
+    return sq.m_elems[0] + sq.m_elems[1] + sq.m_elems[2];
   }
 
   [[nodiscard]] constexpr auto length() const noexcept -> value_type
     requires(sqrt_compatible<value_type>)
   {
+    // the newton iteration is only there for constant evaluation, hardware sqrt is both faster
+    // and correctly rounded
+    if !consteval {
+      return std::sqrt(length_squared());
+    }
     return sqrt_constexpr(length_squared());
   }
 
@@ -52,17 +78,11 @@ public:
   }
 
   constexpr auto operator+=(const vec3<value_type>& v) noexcept -> vec3<value_type>& {
-    m_elems[0] += v.m_elems[0];
-    m_elems[1] += v.m_elems[1];
-    m_elems[2] += v.m_elems[2];
-    return *this;
+    return *this = *this + v;
   }
 
   constexpr auto operator*=(const value_type t) noexcept -> vec3<value_type>& {
-    m_elems[0] *= t;
-    m_elems[1] *= t;
-    m_elems[2] *= t;
-    return *this;
+    return *this = t * *this;
   }
 
   constexpr auto operator/=(const value_type t) noexcept -> vec3<value_type>&
@@ -72,33 +92,58 @@ public:
     return *this *= value_type{1} / t;
   }
 
-  // hidden friends
+  // hidden friends, each takes the simd path at runtime when the storage allows it
   [[nodiscard]] friend constexpr auto operator+(const vec3<value_type>& u,
                                                 const vec3<value_type>& v) noexcept
       -> vec3<value_type> {
+    if constexpr (storage::vectorised) {
+      if !consteval {
+        return vec3<value_type>{simd::map(u.m_elems, v.m_elems, std::plus<>{})};
+      }
+    }
     return vec3<value_type>{u.x() + v.x(), u.y() + v.y(), u.z() + v.z()};
   }
 
   [[nodiscard]] friend constexpr auto operator-(const vec3<value_type>& v) noexcept
       -> vec3<value_type> {
+    if constexpr (storage::vectorised) {
+      if !consteval {
+        return vec3<value_type>{simd::map(v.m_elems, std::negate<>{})};
+      }
+    }
     return vec3<value_type>{-v.x(), -v.y(), -v.z()};
   }
 
   [[nodiscard]] friend constexpr auto operator-(const vec3<value_type>& u,
                                                 const vec3<value_type>& v) noexcept
       -> vec3<value_type> {
+    if constexpr (storage::vectorised) {
+      if !consteval {
+        return vec3<value_type>{simd::map(u.m_elems, v.m_elems, std::minus<>{})};
+      }
+    }
     return vec3<value_type>{u.x() - v.x(), u.y() - v.y(), u.z() - v.z()};
   }
 
   [[nodiscard]] friend constexpr auto operator*(const vec3<value_type>& u,
                                                 const vec3<value_type>& v) noexcept
       -> vec3<value_type> {
+    if constexpr (storage::vectorised) {
+      if !consteval {
+        return vec3<value_type>{simd::map(u.m_elems, v.m_elems, std::multiplies<>{})};
+      }
+    }
     return vec3<value_type>{u.x() * v.x(), u.y() * v.y(), u.z() * v.z()};
   }
 
   [[nodiscard]] friend constexpr auto operator*(const value_type t,
                                                 const vec3<value_type>& v) noexcept
       -> vec3<value_type> {
+    if constexpr (storage::vectorised) {
+      if !consteval {
+        return vec3<value_type>{simd::map(v.m_elems, [t](const auto r) noexcept { return t * r; })};
+      }
+    }
     return vec3<value_type>{t * v.x(), t * v.y(), t * v.z()};
   }
 
@@ -115,12 +160,24 @@ public:
   }
 
 private:
-  std::array<value_type, 3> m_elems{};
+  using storage_type = std::array<value_type, storage::lanes>;
+
+  [[nodiscard]] constexpr explicit vec3(const storage_type& elems) noexcept : m_elems{elems} {}
+
+  alignas(storage::alignment) storage_type m_elems{};
 };
 
 template <vec3_value_type_compatible T>
 [[nodiscard]] constexpr auto dot(const vec3<T>& u, const vec3<T>& v) noexcept -> T {
-  return u.x() * v.x() + u.y() * v.y() + u.z() * v.z();
+  // products go through the (possibly vectorised) element-wise multiply
+  const vec3<T> p = u * v;
+  return p.x() + p.y() + p.z();
+}
+
+template <vec3_value_type_compatible T>
+[[nodiscard]] constexpr auto cross(const vec3<T>& u, const vec3<T>& v) noexcept -> vec3<T> {
+  return vec3<T>{u.y() * v.z() - u.z() * v.y(), u.z() * v.x() - u.x() * v.z(),
+                 u.x() * v.y() - u.y() * v.x()};
 }
 
 template <vec3_value_type_compatible T>
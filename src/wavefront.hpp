@@ -0,0 +1,517 @@
+#ifndef WAVEFRONT_HPP
+#define WAVEFRONT_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "camera.hpp"
+#include "colour.hpp"
+#include "frustum.hpp"
+#include "image.hpp"
+#include "ray.hpp"
+#include "render.hpp"
+#include "scene.hpp"
+#include "util.hpp"
+
+// wavefront runtime renderer, rather than following one ray at a time through the whole pipeline
+// every ray in flight goes through each stage together...
+//
+//   generate  - all camera rays for a band of the frame into a ray queue, tile by tile
+//   sort      - bin secondary rays by direction octant, then direction, for coherence
+//   intersect - closest hit for each camera ray, or any hit for each shadow ray, object by object
+//               over batches of the queue
+//   shade     - colour each ray into its pixel, rays that carry on go into the next queue
+//
+// camera rays that land on a lit surface draw a light and carry on as a shadow ray towards it,
+// the next generation. hits live in structure of arrays buffers, and each batch of rays is
+// transposed into one, s.t. the intersect loops vectorise
+
+namespace rt::wavefront {
+
+struct wavefront_settings {
+  // camera rays generated per wave, the frame goes through the pipeline in bands of whole tile
+  // rows holding about this many rays s.t. the queues stay in cache
+  std::size_t rays_in_flight = std::size_t{1} << 14;
+  // rays per intersect batch for generations after the first, sized to keep a batch's buffers in
+  // cache... camera rays are batched per tile instead
+  std::size_t batch_size = 4096;
+  // stop after this many generations of rays, shadow rays are the second
+  std::size_t max_depth = 8;
+  // camera rays come out of generate already coherent, so only later generations are sorted
+  bool sort_rays = true;
+};
+
+// every ray in a queue is of one kind, a generation never mixes them
+enum class ray_kind : std::uint8_t {
+  // closest hit wanted, shaded where it lands
+  camera,
+  // only whether anything is in the way matters
+  shadow,
+};
+
+template <std::floating_point T> class ray_queue {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  void clear(const ray_kind kind = ray_kind::camera) noexcept {
+    m_rays.clear();
+    m_pixels.clear();
+    m_light_us.clear();
+    m_t_max.clear();
+    m_radiance.clear();
+    m_kind = kind;
+  }
+
+  void reserve(const size_type n) {
+    m_rays.reserve(n);
+    m_pixels.reserve(n);
+    if (m_kind == ray_kind::camera) {
+      m_light_us.reserve(n);
+    } else {
+      m_t_max.reserve(n);
+      m_radiance.reserve(n);
+    }
+  }
+
+  // room for n camera rays, generate knows up front how many it makes and fills each one in with
+  // set
+  void resize(const size_type n) {
+    assert(m_kind == ray_kind::camera && "only camera queues are filled in place");
+    m_rays.resize(n);
+    m_pixels.resize(n);
+    m_light_us.resize(n);
+  }
+
+  // camera ray i, light_u picks the light sampled where it lands
+  void set(const size_type i, const ray<T>& r, const std::uint32_t pixel,
+           const T light_u) noexcept {
+    m_rays[i] = r;
+    m_pixels[i] = pixel;
+    m_light_us[i] = light_u;
+  }
+
+  // a shadow ray reaching as far as t_max, radiance goes into its pixel if nothing is in the way
+  void push(const ray<T>& r, const std::uint32_t pixel, const T t_max, const colour<T>& radiance) {
+    assert(m_kind == ray_kind::shadow && "shadow ray pushed onto a camera queue");
+    m_rays.push_back(r);
+    m_pixels.push_back(pixel);
+    m_t_max.push_back(t_max);
+    m_radiance.push_back(radiance);
+  }
+
+  [[nodiscard]] auto kind() const noexcept -> ray_kind {
+    return m_kind;
+  }
+
+  [[nodiscard]] auto size() const noexcept -> size_type {
+    return m_rays.size();
+  }
+  [[nodiscard]] auto empty() const noexcept -> bool {
+    return m_rays.empty();
+  }
+
+  [[nodiscard]] auto at(const size_type i) const noexcept -> const ray<T>& {
+    return m_rays[i];
+  }
+  [[nodiscard]] auto pixel(const size_type i) const noexcept -> std::uint32_t {
+    return m_pixels[i];
+  }
+  [[nodiscard]] auto light_u(const size_type i) const noexcept -> T {
+    return m_light_us[i];
+  }
+  // shadow rays only
+  [[nodiscard]] auto t_max() const noexcept -> const std::vector<T>& {
+    return m_t_max;
+  }
+  [[nodiscard]] auto radiance(const size_type i) const noexcept -> colour<T> {
+    return m_radiance[i];
+  }
+
+  // this queue becomes from reordered, s.t. ray i is from's ray order[i]... keeps its own capacity
+  void gather(const ray_queue<T>& from, const std::vector<size_type>& order) {
+    clear(from.m_kind);
+    gather(m_rays, from.m_rays, order);
+    gather(m_pixels, from.m_pixels, order);
+    if (m_kind == ray_kind::camera) {
+      gather(m_light_us, from.m_light_us, order);
+    } else {
+      gather(m_t_max, from.m_t_max, order);
+      gather(m_radiance, from.m_radiance, order);
+    }
+  }
+
+private:
+  template <typename U>
+  static void gather(std::vector<U>& to, const std::vector<U>& from,
+                     const std::vector<size_type>& order) {
+    to.resize(order.size());
+    for (size_type i = 0; i < order.size(); ++i) {
+      to[i] = from[order[i]];
+    }
+  }
+
+  // whole rays rather than soa lanes, shade rebuilding a ray from lanes it just wrote stalls on
+  // every load... intersect transposes each batch into ray_lanes instead
+  std::vector<ray<T>> m_rays;
+  // into the pixel sums of the band in flight
+  std::vector<std::uint32_t> m_pixels;
+  // camera rays
+  std::vector<T> m_light_us;
+  // shadow rays
+  std::vector<T> m_t_max;
+  std::vector<colour<T>> m_radiance;
+  ray_kind m_kind{ray_kind::camera};
+};
+
+// a run of the queue intersected together and the objects its rays might hit
+struct ray_batch {
+  std::size_t begin;
+  std::size_t end;
+  std::span<const std::size_t> candidates;
+};
+
+// one batch of the queue transposed into structure of arrays s.t. the lane kernels run straight
+// down each component
+template <std::floating_point T> class ray_lanes {
+public:
+  void load(const ray_queue<T>& queue, const ray_batch& batch) {
+    m_size = batch.end - batch.begin;
+    for (auto* lane : {&m_ox, &m_oy, &m_oz, &m_dx, &m_dy, &m_dz}) {
+      lane->resize(m_size);
+    }
+    if (m_taken_capacity < m_size) {
+      m_taken = std::make_unique_for_overwrite<bool[]>(m_size);
+      m_taken_capacity = m_size;
+    }
+    for (std::size_t i = 0; i < m_size; ++i) {
+      const auto& r = queue.at(batch.begin + i);
+      const auto o = r.origin();
+      const auto d = r.direction();
+      m_ox[i] = o.x();
+      m_oy[i] = o.y();
+      m_oz[i] = o.z();
+      m_dx[i] = d.x();
+      m_dy[i] = d.y();
+      m_dz[i] = d.z();
+    }
+  }
+
+  [[nodiscard]] auto soa() const noexcept -> ray_soa<T> {
+    return {m_ox, m_oy, m_oz, m_dx, m_dy, m_dz};
+  }
+
+  // a flag per lane for the lane kernels to write which lanes an object took into
+  [[nodiscard]] auto taken() noexcept -> std::span<bool> {
+    return {m_taken.get(), m_size};
+  }
+
+private:
+  std::vector<T> m_ox;
+  std::vector<T> m_oy;
+  std::vector<T> m_oz;
+  std::vector<T> m_dx;
+  std::vector<T> m_dy;
+  std::vector<T> m_dz;
+  // no vector<bool> as the kernels want a span
+  std::unique_ptr<bool[]> m_taken;
+  std::size_t m_taken_capacity{};
+  std::size_t m_size{};
+};
+
+// closest hit per queued ray, object is no_hit for misses
+template <std::floating_point T> struct hit_buffer {
+  static constexpr std::uint32_t no_hit = std::numeric_limits<std::uint32_t>::max();
+
+  // camera rays reach as far as they like, shadow rays only as far as their light
+  void reset(const ray_queue<T>& queue) {
+    if (queue.kind() == ray_kind::shadow) {
+      t = queue.t_max();
+    } else {
+      t.assign(queue.size(), std::numeric_limits<T>::infinity());
+    }
+    object.assign(queue.size(), no_hit);
+  }
+
+  std::vector<T> t;
+  std::vector<std::uint32_t> object;
+};
+
+namespace detail {
+
+// interleaves the low 3 bits of x, y and z, x lowest
+[[nodiscard]] constexpr auto interleave3(const std::uint32_t x, const std::uint32_t y,
+                                         const std::uint32_t z) noexcept -> std::uint32_t {
+  std::uint32_t bits = 0;
+  for (std::uint32_t bit = 0; bit < 3; ++bit) {
+    bits |= ((x >> bit) & 1U) << (3 * bit);
+    bits |= ((y >> bit) & 1U) << (3 * bit + 1);
+    bits |= ((z >> bit) & 1U) << (3 * bit + 2);
+  }
+  return bits;
+}
+
+} // namespace detail
+
+// bins rays by direction octant first, then by a coarse morton order of their direction... a
+// stable counting sort over a few thousand bins rather than a full sort, rays within a bin keep
+// the order shade made them in, i.e. tile by tile across the band, s.t. rays that are close in
+// the sorted queue tend to start near each other and visit the same objects in the same order.
+// the buffers are kept from one wave to the next s.t. sorting doesn't allocate
+template <std::floating_point T> class ray_sorter {
+public:
+  void sort(ray_queue<T>& queue) {
+    const std::size_t n = queue.size();
+    if (n < 2) {
+      return;
+    }
+
+    m_keys.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto d = queue.at(i).direction();
+      const std::uint32_t octant =
+          (d.x() < T{0} ? 1U : 0U) | (d.y() < T{0} ? 2U : 0U) | (d.z() < T{0} ? 4U : 0U);
+      // the octant has the signs, 3 bits of each magnitude over the largest one does for the
+      // rest... no square root, and the same bins for any length of direction
+      const T x = std::abs(d.x());
+      const T y = std::abs(d.y());
+      const T z = std::abs(d.z());
+      const T scale = T{8} / std::max({x, y, z});
+      const auto quantise = [scale](const T v) noexcept -> std::uint32_t {
+        return std::min(static_cast<std::uint32_t>(v * scale), 7U);
+      };
+      m_keys[i] = static_cast<std::uint16_t>((octant << 9) |
+                                             detail::interleave3(quantise(x), quantise(y),
+                                                                 quantise(z)));
+    }
+
+    m_starts.fill(0);
+    for (const auto key : m_keys) {
+      ++m_starts[key + 1];
+    }
+    std::partial_sum(m_starts.begin(), m_starts.end(), m_starts.begin());
+
+    m_order.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      m_order[m_starts[m_keys[i]]++] = i;
+    }
+    m_sorted.gather(queue, m_order);
+    std::swap(queue, m_sorted);
+  }
+
+private:
+  // 3 octant bits over 9 direction bits
+  static constexpr std::size_t bins = std::size_t{1} << 12;
+
+  std::vector<std::uint16_t> m_keys;
+  std::array<std::size_t, bins + 1> m_starts{};
+  std::vector<std::size_t> m_order;
+  ray_queue<T> m_sorted;
+};
+
+// closest candidate per ray, object major over one batch... each candidate's lane kernel takes
+// the whole batch in one go and lowers t where it is closer
+template <boundable T, std::size_t N, std::size_t L>
+void intersect(ray_lanes<extracted_value_type_of_t<T>>& rays, const scene<T, N, L>& world,
+               const ray_batch& batch, const extracted_value_type_of_t<T> t_min,
+               hit_buffer<extracted_value_type_of_t<T>>& hits) {
+  const auto objects = world.objects();
+  const auto t = std::span{hits.t}.subspan(batch.begin, batch.end - batch.begin);
+  const auto taken = rays.taken();
+  for (const std::size_t obj : batch.candidates) {
+    objects[obj].hit(rays.soa(), t_min, t, taken);
+    for (std::size_t j = 0; j < taken.size(); ++j) {
+      auto& object = hits.object[batch.begin + j];
+      object = taken[j] ? static_cast<std::uint32_t>(obj) : object;
+    }
+  }
+}
+
+// shadow rays only need to know whether anything is in the way, i.e. whether anything is hit short
+// of the light t starts at... the closest such hit is as good as any
+template <boundable T, std::size_t N, std::size_t L>
+void occlude(ray_lanes<extracted_value_type_of_t<T>>& rays, const scene<T, N, L>& world,
+             const ray_batch& batch, hit_buffer<extracted_value_type_of_t<T>>& hits) {
+  intersect(rays, world, batch, static_cast<extracted_value_type_of_t<T>>(shadow_epsilon), hits);
+}
+
+// adds each ray's colour into its pixel's sum... camera rays that land on a lit surface draw a
+// light and push a shadow ray towards it onto next instead, carrying what the light would add.
+// shadow rays add it if nothing got in the way
+template <boundable T, std::size_t N, std::size_t L>
+void shade(const ray_queue<extracted_value_type_of_t<T>>& queue, const scene<T, N, L>& world,
+           const hit_buffer<extracted_value_type_of_t<T>>& hits,
+           std::vector<colour<extracted_value_type_of_t<T>>>& sums,
+           ray_queue<extracted_value_type_of_t<T>>& next) {
+  using float_type = extracted_value_type_of_t<T>;
+
+  if (queue.kind() == ray_kind::shadow) {
+    for (std::size_t i = 0; i < queue.size(); ++i) {
+      if (hits.object[i] == hit_buffer<float_type>::no_hit) {
+        auto& sum = sums[queue.pixel(i)];
+        sum = sum + queue.radiance(i);
+      }
+    }
+    return;
+  }
+
+  const auto objects = world.objects();
+  for (std::size_t i = 0; i < queue.size(); ++i) {
+    const ray<float_type>& r = queue.at(i);
+    auto& sum = sums[queue.pixel(i)];
+    if (hits.object[i] == hit_buffer<float_type>::no_hit) {
+      sum = sum + rt::shade(r, std::optional<hit_record<float_type>>{});
+      continue;
+    }
+
+    const std::optional hit{objects[hits.object[i]].record(r, hits.t[i])};
+    if constexpr (L > 0) {
+      if (world.has_lights()) {
+        const auto path = sample_direct(world, *hit, queue.light_u(i));
+        if (path) {
+          next.push(path->shadow, queue.pixel(i), path->distance,
+                    rt::shade(r, hit) * path->radiance);
+        }
+        continue;
+      }
+    }
+    sum = sum + rt::shade(r, hit);
+  }
+}
+
+// double only, camera rays come out of camera_rays as ray_d
+template <std::size_t Width, std::size_t Height, std::size_t TileSize = default_tile_size,
+          boundable T, std::size_t N, std::size_t L>
+  requires(valid_image_dimensions<Width, Height> && (Width > 1) && (Height > 1) &&
+           std::same_as<extracted_value_type_of_t<T>, double>)
+[[nodiscard]] inline auto render(const scene<T, N, L>& world, const camera& cam,
+                                 const render_settings& settings,
+                                 const wavefront_settings& wave = {}) -> image<Width, Height>
+  requires requires(const T& obj, ray_soa<double> rays, std::span<double> t, std::span<bool> taken) {
+    obj.hit(rays, 0.0, t, taken);
+  }
+{
+  using grid = tile_grid<Width, Height, TileSize>;
+  using float_type = extracted_value_type_of_t<T>;
+  assert(settings.samples_per_pixel > 0 && "need at least one sample per pixel");
+  assert(wave.batch_size > 0 && "batching needs at least one ray per batch");
+
+  image<Width, Height> img{};
+  ray_queue<float_type> queue;
+  ray_queue<float_type> next;
+  hit_buffer<float_type> hits;
+  std::vector<ray_batch> batches;
+  ray_lanes<float_type> lanes;
+  ray_sorter<float_type> sorter;
+
+  // camera rays only test the objects culled for their tile, later generations test them all
+  const auto tiles = cull_tiles<Width, Height, TileSize>(cam, world);
+  std::vector<std::size_t> every_object(world.objects().size());
+  std::iota(every_object.begin(), every_object.end(), std::size_t{0});
+
+  // generate, sample offsets are the same for every pixel...
+  const camera_rays<Width, Height> rays{cam};
+  std::vector<vec3<double>> offsets(settings.samples_per_pixel);
+  for (std::size_t s = 0; s < offsets.size(); ++s) {
+    offsets[s] = rays.offset(radical_inverse<double>(2, s), radical_inverse<double>(3, s));
+  }
+
+  const std::size_t rays_per_tile_row = Width * TileSize * offsets.size();
+  const std::size_t tile_rows_per_wave =
+      std::max(std::size_t{1}, wave.rays_in_flight / rays_per_tile_row);
+  queue.reserve(tile_rows_per_wave * rays_per_tile_row);
+
+  // every sample is summed into its pixel, the average is taken on the way out as render_pixel
+  // does... only for the band in flight, every generation of a band is done before the next one
+  // starts
+  std::vector<colour<float_type>> sums(tile_rows_per_wave * TileSize * Width);
+  const float_type scale = float_type{1} / static_cast<float_type>(settings.samples_per_pixel);
+
+  for (std::size_t band = 0; band < grid::tiles_y; band += tile_rows_per_wave) {
+    const std::size_t band_end = std::min(band + tile_rows_per_wave, grid::tiles_y);
+    const std::size_t first_row = band * TileSize;
+    const std::size_t last_row = std::min(band_end * TileSize, Height);
+    queue.clear();
+    queue.resize((last_row - first_row) * Width * offsets.size());
+    batches.clear();
+    std::size_t i = 0;
+    // tile by tile, s.t. each batch of camera rays shares its tile's candidates
+    for (std::size_t ty = band; ty < band_end; ++ty) {
+      const std::size_t row_end = std::min((ty + 1) * TileSize, Height);
+      for (std::size_t tx = 0; tx < grid::tiles_x; ++tx) {
+        const std::size_t col_end = std::min((tx + 1) * TileSize, Width);
+        const std::size_t begin = i;
+        for (std::size_t row = ty * TileSize; row < row_end; ++row) {
+          for (std::size_t col = tx * TileSize; col < col_end; ++col) {
+            const auto pixel = static_cast<std::uint32_t>((row - first_row) * Width + col);
+            for (std::size_t s = 0; s < offsets.size(); ++s) {
+              // only lit scenes ever look at light_u
+              const float_type light_u =
+                  L > 0 ? static_cast<float_type>(light_sample_value(col, row, s)) : float_type{0};
+              queue.set(i, rays.get_ray(col, row, offsets[s]), pixel, light_u);
+              i += 1;
+            }
+          }
+        }
+        batches.push_back({begin, i, tiles[ty * grid::tiles_x + tx].indices()});
+      }
+    }
+
+    for (std::size_t depth = 0; depth < wave.max_depth && !queue.empty(); ++depth) {
+      if (depth > 0) {
+        if (wave.sort_rays) {
+          sorter.sort(queue);
+        }
+        batches.clear();
+        for (std::size_t begin = 0; begin < queue.size(); begin += wave.batch_size) {
+          batches.push_back(
+              {begin, std::min(begin + wave.batch_size, queue.size()), every_object});
+        }
+      }
+
+      hits.reset(queue);
+      for (const auto& batch : batches) {
+        // nothing to test against, e.g. a tile of sky
+        if (batch.candidates.empty()) {
+          continue;
+        }
+        lanes.load(queue, batch);
+        if (queue.kind() == ray_kind::shadow) {
+          occlude(lanes, world, batch, hits);
+        } else {
+          intersect(lanes, world, batch, std::numeric_limits<float_type>::epsilon(), hits);
+        }
+      }
+
+      // the only rays shade spawns are shadow rays
+      next.clear(ray_kind::shadow);
+      shade(queue, world, hits, sums, next);
+      std::swap(queue, next);
+    }
+
+    for (std::size_t row = first_row; row < last_row; ++row) {
+      for (std::size_t col = 0; col < Width; ++col) {
+        auto& sum = sums[(row - first_row) * Width + col];
+        img.set_pixel(col, Height - row - 1, colour_to_pixel<float_type, std::uint8_t>(sum * scale));
+        sum = colour<float_type>{};
+      }
+    }
+  }
+
+  return img;
+}
+
+} // namespace rt::wavefront
+
+#endif // WAVEFRONT_HPP